@@ -0,0 +1,525 @@
+// c4bridge - lets any number of spectators watch the board's UART stream.
+//
+// Reads the board's serial stream once (a device, a pty a stand-in for the
+// board writes to, or stdin, which may also be a capture file) and copies it first to stdout, the player's
+// own view, then to every spectator connected on a Unix socket or a TCP
+// port on the loopback interface. Spectators get exactly the bytes the
+// board sent, so a plain terminal (text mode) or c4view (binary mode)
+// works on the other end:
+//
+//     nc 127.0.0.1 4040                  text mode
+//     nc 127.0.0.1 4040 | c4view         binary mode
+//
+// Each read from the board becomes one chunk that every spectator's queue
+// points at, so a spectator costs a reference, not a copy, and the chunk is
+// freed once the last spectator has been sent it. Everything runs off one
+// epoll loop; spectators are written without blocking, and one that falls
+// more than the queue limit behind is disconnected instead of holding
+// anyone up.
+//
+// A spectator joining mid-game is first sent the stream from the start of
+// the current screen: the last clear-screen in text mode, or the last
+// whole MSG_SELECT or MSG_NEW_GAME frame with a good CRC in binary mode. That is enough for it
+// to draw the board as it is now.
+//
+// Build: g++ -std=c++17 -O2 -o c4bridge host/c4bridge.cpp
+// Usage: c4bridge [-b baud] [-u socket] [-p port] [-q limit] [device]
+//        (default 9600 baud, TCP port 4040, 1 MB queue limit, stdin)
+
+#include "firmware.hpp"
+#include "protocol.hpp"
+#include "serial.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Bytes from one read of the board, never changed once shared.
+using Chunk = std::vector<std::uint8_t>;
+using ChunkPtr = std::shared_ptr<const Chunk>;
+
+struct Slice {
+    ChunkPtr chunk;
+    std::size_t offset;
+};
+
+// Keeps the chunks since the current screen started, for late joiners.
+class Snapshot {
+public:
+    explicit Snapshot(std::size_t limit) : limit_(limit)
+    {
+        parser_.on_text = [this](std::uint8_t c) {
+            window_ = window_ << 8 | c;
+            if (std::uint32_t(window_) == 0x1B5B324Au) // ESC [ 2 J
+                start_ = pos_ - 3;
+        };
+        // called on the CRC byte, the frame began its length and three
+        // more bytes back
+        parser_.on_frame = [this](const c4::Frame& f) {
+            if (f.type == MSG_SELECT || f.type == MSG_NEW_GAME)
+                start_ = pos_ - f.length - 3;
+        };
+    }
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    void add(const ChunkPtr& chunk)
+    {
+        std::uint64_t base = end_;
+        chunks_.push_back({ base, chunk });
+        end_ += chunk->size();
+        held_ += chunk->size();
+
+        for (std::size_t i = 0; i < chunk->size(); i++) {
+            pos_ = base + i;
+            parser_.feed((*chunk)[i]);
+        }
+
+        // drop what is before the screen start, and the oldest chunks if
+        // a screen is ever bigger than the limit
+        while (!chunks_.empty()) {
+            const Held& h = chunks_.front();
+            bool before = h.base + h.chunk->size() <= start_;
+            if (!before && held_ <= limit_)
+                break;
+            held_ -= h.chunk->size();
+            chunks_.pop_front();
+        }
+        if (!chunks_.empty())
+            start_ = std::max(start_, chunks_.front().base);
+    }
+
+    // The current screen so far, as slices for a new spectator's queue.
+    void fill(std::deque<Slice>& out, std::size_t& bytes) const
+    {
+        for (const Held& h : chunks_) {
+            std::size_t offset = start_ > h.base ? std::size_t(start_ - h.base) : 0;
+            if (offset >= h.chunk->size())
+                continue;
+            out.push_back({ h.chunk, offset });
+            bytes += h.chunk->size() - offset;
+        }
+    }
+
+private:
+    struct Held {
+        std::uint64_t base; // stream position of the chunk's first byte
+        ChunkPtr chunk;
+    };
+
+    std::size_t limit_;
+    std::deque<Held> chunks_;
+    std::size_t held_ = 0;
+    std::uint64_t end_ = 0;
+    std::uint64_t start_ = 0;
+    c4::FrameParser parser_;
+    std::uint64_t pos_ = 0;    // stream position of the byte being parsed
+    std::uint64_t window_ = 0; // last text bytes seen, newest lowest
+};
+
+struct Spectator {
+    std::deque<Slice> queue;
+    std::size_t queued = 0; // bytes
+    bool reading = true; // until they shut down their side
+    std::uint32_t events = 0;
+};
+
+struct Stats {
+    unsigned long joined = 0;
+    unsigned long peak = 0;
+    unsigned long dropped = 0; // too slow
+    unsigned long long bytes_in = 0;
+    unsigned long long bytes_out = 0;
+};
+
+volatile std::sig_atomic_t stop = 0;
+
+void on_signal(int) { stop = 1; }
+
+bool write_all(int fd, const std::uint8_t* p, std::size_t n)
+{
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        p += w;
+        n -= std::size_t(w);
+    }
+    return true;
+}
+
+int listen_tcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(std::uint16_t(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listen_unix(const char* path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof addr.sun_path - 1);
+    unlink(path);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+class Bridge {
+public:
+    Bridge(int epoll_fd, std::size_t queue_limit) : epoll_(epoll_fd), limit_(queue_limit) {}
+
+    void join(int fd, const Snapshot& snapshot)
+    {
+        Spectator& s = spectators_[fd];
+        snapshot.fill(s.queue, s.queued);
+
+        epoll_event ev {};
+        ev.events = s.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            spectators_.erase(fd);
+            return;
+        }
+
+        stats.joined++;
+        stats.peak = std::max<unsigned long>(stats.peak, spectators_.size());
+        flush(fd);
+    }
+
+    void leave(int fd)
+    {
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        spectators_.erase(fd);
+    }
+
+    // A new chunk for everyone. Spectators that were idle are written to
+    // straight away, the rest when epoll says they can take more.
+    void publish(const ChunkPtr& chunk)
+    {
+        std::vector<int> idle;
+        std::vector<int> slow;
+        for (auto& entry : spectators_) {
+            Spectator& s = entry.second;
+            bool was_empty = s.queue.empty();
+            s.queue.push_back({ chunk, 0 });
+            s.queued += chunk->size();
+            if (s.queued > limit_)
+                slow.push_back(entry.first);
+            else if (was_empty)
+                idle.push_back(entry.first);
+        }
+        for (int fd : slow) {
+            stats.dropped++;
+            leave(fd);
+        }
+        for (int fd : idle)
+            flush(fd);
+    }
+
+    void flush(int fd)
+    {
+        auto it = spectators_.find(fd);
+        if (it == spectators_.end())
+            return;
+        Spectator& s = it->second;
+
+        while (!s.queue.empty()) {
+            iovec iov[64];
+            int n = 0;
+            for (auto q = s.queue.begin(); q != s.queue.end() && n < 64; ++q, ++n) {
+                iov[n].iov_base = const_cast<std::uint8_t*>(q->chunk->data() + q->offset);
+                iov[n].iov_len = q->chunk->size() - q->offset;
+            }
+
+            ssize_t w = writev(fd, iov, n);
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (w < 0) {
+                leave(fd);
+                return;
+            }
+
+            stats.bytes_out += std::size_t(w);
+            s.queued -= std::size_t(w);
+            std::size_t left = std::size_t(w);
+            while (left) {
+                Slice& front = s.queue.front();
+                std::size_t size = front.chunk->size() - front.offset;
+                if (left < size) {
+                    front.offset += left;
+                    break;
+                }
+                left -= size;
+                s.queue.pop_front();
+            }
+        }
+
+        update(fd, s);
+    }
+
+    // Spectators have nothing to say, anything they send is thrown away.
+    // One that shuts its side down (nc with stdin closed) keeps watching;
+    // it is only dropped when a write to it fails.
+    void drain(int fd)
+    {
+        Spectator& s = spectators_.at(fd);
+        char buf[256];
+        for (;;) {
+            ssize_t n = read(fd, buf, sizeof buf);
+            if (n > 0)
+                continue;
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                leave(fd);
+                return;
+            }
+            if (n == 0)
+                s.reading = false;
+            break;
+        }
+        update(fd, s);
+    }
+
+    bool has(int fd) const { return spectators_.count(fd) != 0; }
+
+    bool backlog() const
+    {
+        for (const auto& entry : spectators_)
+            if (!entry.second.queue.empty())
+                return true;
+        return false;
+    }
+
+    Stats stats;
+
+private:
+    // Listen for input while they may send some, for output while their
+    // queue is not empty.
+    void update(int fd, Spectator& s)
+    {
+        std::uint32_t events = (s.reading ? EPOLLIN : 0u) | (s.queue.empty() ? 0u : EPOLLOUT);
+        if (events == s.events)
+            return;
+        epoll_event ev {};
+        ev.events = s.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    int epoll_;
+    std::size_t limit_;
+    std::unordered_map<int, Spectator> spectators_;
+};
+
+// Returns false with errno set when epoll cannot watch fd, EPERM for a
+// regular file or /dev/null, which are always readable.
+bool watch(int epoll_fd, int fd)
+{
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long baud = 9600;
+    int port = -1;
+    const char* unix_path = nullptr;
+    std::size_t queue_limit = 1 << 20;
+    const char* device = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            baud = std::strtol(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "-p") && i + 1 < argc)
+            port = int(std::strtol(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-u") && i + 1 < argc)
+            unix_path = argv[++i];
+        else if (!std::strcmp(argv[i], "-q") && i + 1 < argc)
+            queue_limit = std::size_t(std::strtoul(argv[++i], nullptr, 10));
+        else
+            device = argv[i];
+    }
+    if (port < 0 && !unix_path)
+        port = 4040;
+
+    if (!c4::to_speed(baud)) {
+        std::fprintf(stderr, "c4bridge: unsupported baud rate %ld\n", baud);
+        return 2;
+    }
+
+    int in = STDIN_FILENO;
+    if (device) {
+        in = c4::open_serial(device, baud);
+        if (in < 0) {
+            std::fprintf(stderr, "c4bridge: %s: %s\n", device, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    // a capture file on stdin is read straight away, a pass of the loop
+    // at a time, instead of waiting for epoll
+    bool input_file = false;
+    if (ep < 0 || !watch(ep, in)) {
+        if (ep < 0 || errno != EPERM) {
+            std::perror("c4bridge: epoll");
+            return 1;
+        }
+        input_file = true;
+    }
+
+    std::vector<int> listeners;
+    if (port >= 0) {
+        int fd = listen_tcp(port);
+        if (fd < 0) {
+            std::fprintf(stderr, "c4bridge: port %d: %s\n", port, std::strerror(errno));
+            return 1;
+        }
+        listeners.push_back(fd);
+    }
+    if (unix_path) {
+        int fd = listen_unix(unix_path);
+        if (fd < 0) {
+            std::fprintf(stderr, "c4bridge: %s: %s\n", unix_path, std::strerror(errno));
+            return 1;
+        }
+        listeners.push_back(fd);
+    }
+    for (int fd : listeners) {
+        if (!watch(ep, fd)) {
+            std::perror("c4bridge: epoll");
+            return 1;
+        }
+    }
+
+    Bridge bridge(ep, queue_limit);
+    Snapshot snapshot(64 * 1024);
+    bool input_open = true;
+    bool primary_open = true;
+
+    // One read from the board, shared as a chunk of exactly the bytes read.
+    auto read_input = [&]() {
+        std::uint8_t buf[4096];
+        ssize_t r = read(in, buf, sizeof buf);
+        if (r < 0 && (errno == EINTR || errno == EAGAIN))
+            return;
+        if (r <= 0) {
+            // end of file, or EIO from a pty whose writer went away
+            if (!input_file)
+                epoll_ctl(ep, EPOLL_CTL_DEL, in, nullptr);
+            input_open = false;
+            return;
+        }
+        ChunkPtr chunk = std::make_shared<const Chunk>(buf, buf + r);
+        bridge.stats.bytes_in += std::size_t(r);
+
+        // the player at the board first
+        if (primary_open && !write_all(STDOUT_FILENO, chunk->data(), chunk->size()))
+            primary_open = false;
+
+        snapshot.add(chunk);
+        bridge.publish(chunk);
+    };
+
+    // After the board's stream ends, give spectators a moment to catch up.
+    while (!stop && (input_open || bridge.backlog())) {
+        if (input_file && input_open)
+            read_input();
+
+        epoll_event events[64];
+        int timeout = !input_open ? 2000 : input_file ? 0 : -1;
+        int n = epoll_wait(ep, events, 64, timeout);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 || (n == 0 && timeout != 0))
+            break;
+
+        for (int e = 0; e < n; e++) {
+            int fd = events[e].data.fd;
+            std::uint32_t what = events[e].events;
+
+            if (fd == in) {
+                read_input();
+            } else if (std::find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+                for (;;) {
+                    int client = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0)
+                        break;
+                    bridge.join(client, snapshot);
+                }
+            } else if (bridge.has(fd)) {
+                if (what & (EPOLLERR | EPOLLHUP)) {
+                    bridge.leave(fd);
+                    continue;
+                }
+                if (what & EPOLLOUT)
+                    bridge.flush(fd);
+                if (bridge.has(fd) && (what & EPOLLIN))
+                    bridge.drain(fd);
+            }
+        }
+    }
+
+    if (unix_path)
+        unlink(unix_path);
+
+    const Stats& s = bridge.stats;
+    std::fprintf(stderr, "c4bridge: %llu bytes from the board, %llu to %lu spectators (at most %lu at once), %lu dropped for falling behind\n",
+        s.bytes_in, s.bytes_out, s.joined, s.peak, s.dropped);
+    return 0;
+}
@@ -0,0 +1,694 @@
+// c4db - builds and queries the game database (host/gamedb.hpp).
+//
+// Games come from text files, one per line:
+//     7x6 3344251                 a game, one digit per move (column)
+//     7x6 O 3344251               the same with O moving first
+//     7x6 33 = -12                a stored value for the position after 33
+// or, with --frames, from captures of the board's binary output (c4view's
+// input, c4bridge's fan-out), where every MSG_NEW_GAME starts a game and
+// names the side to move first. Moves are replayed with the host rules,
+// so illegal games are refused and results are filled in. A captured game
+// is also refused when a MSG_MOVE's piece or row disagrees with the
+// replay, or when the board sent several moves in one drawing (its side
+// to move is then the piece's own) and their order is lost.
+//
+// Building sorts one entry per (position, game) in runs that fit the
+// memory limit, spills each run to a temporary file and merges them while
+// writing the database, so the input can be far bigger than memory.
+// Queries map the file and read a handful of pages.
+//
+// Build: g++ -std=c++17 -O2 -o c4db host/c4db.cpp
+// Usage: c4db build [--frames] [-m MB] out.db [input...]   (stdin if none)
+//        c4db info db
+//        c4db games db WxH moves [-n max]   games through the position
+//        c4db value db WxH moves            stored value and results
+//        c4db test                          builds from sample captures and
+//                                           checks what was kept, exits 1 if
+//                                           anything is wrong
+
+#include "gamedb.hpp"
+#include "protocol.hpp"
+#include "rules.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+// Value entries sort after the games of their position.
+constexpr std::uint32_t VALUE_ENTRY = 0xFFFFFFFFu;
+
+struct Entry {
+    std::uint64_t hash;
+    c4::PosKey key;
+    std::uint32_t game; // or VALUE_ENTRY
+    std::int32_t value;
+};
+
+bool entry_less(const Entry& a, const Entry& b)
+{
+    if (a.hash != b.hash)
+        return a.hash < b.hash;
+    if (!(a.key == b.key))
+        return a.key < b.key;
+    return a.game < b.game;
+}
+
+// A replayed game: the canonical key after each move, the first being
+// the empty board.
+struct Replay {
+    unsigned width = 0;
+    unsigned height = 0;
+    c4::Player first = c4::X;
+    char result = '?';
+    std::vector<c4::PosKey> keys;
+};
+
+// Plays moves on a width x height board, first moving first. Returns false
+// if the size is not one of GEOMETRIES, a move is illegal, or the game
+// goes on after a win.
+bool replay(unsigned width, unsigned height, c4::Player first, const std::vector<std::uint8_t>& moves, Replay& out)
+{
+    bool ok = true;
+    bool found = c4::with_geometry(width, height, [&](auto g) {
+        typename decltype(g)::board b;
+        std::uint8_t heights[9] = {};
+        std::uint8_t x_cols[9] = {};
+        auto key = [&] {
+            for (unsigned i = 0; i < width; i++) {
+                heights[i] = std::uint8_t(b.column_height(i));
+                x_cols[i] = b.columns(c4::X)[i];
+            }
+            return c4::canonical_key(width, height, heights, x_cols);
+        };
+
+        out = Replay();
+        out.width = width;
+        out.height = height;
+        out.first = first;
+        out.keys.push_back(key());
+        c4::Player p = first;
+        for (std::uint8_t col : moves) {
+            if (out.result != '?' || b.drop(col, p) < 0) {
+                ok = false;
+                return;
+            }
+            out.keys.push_back(key());
+            if (b.wins(p))
+                out.result = c4::piece_char(p);
+            else if (b.full())
+                out.result = ' ';
+            p = c4::other(p);
+        }
+    });
+    return found && ok;
+}
+
+class Builder {
+public:
+    Builder(std::FILE* out, std::size_t run_entries) : out_(out), run_limit_(run_entries)
+    {
+        std::memset(&header_, 0, sizeof header_);
+        std::fwrite(&header_, sizeof header_, 1, out_);
+        header_.game_data = sizeof header_;
+    }
+
+    void add_game(const Replay& r, const std::vector<std::uint8_t>& moves)
+    {
+        std::uint32_t n = std::uint32_t(game_offsets_.size());
+        game_offsets_.push_back(game_bytes_);
+        std::uint8_t head[3] = { std::uint8_t(r.width << 4 | r.height), std::uint8_t(r.result), std::uint8_t(c4::piece_char(r.first)) };
+        std::fwrite(head, 1, 3, out_);
+        std::fwrite(moves.data(), 1, moves.size(), out_);
+        game_bytes_ += 3 + moves.size();
+
+        for (const auto& k : r.keys)
+            push({ c4::key_hash(k), k, n, 0 });
+    }
+
+    void add_value(const c4::PosKey& k, int value) { push({ c4::key_hash(k), k, VALUE_ENTRY, value }); }
+
+    std::uint64_t games() const { return game_offsets_.size(); }
+
+    // Writes everything after the game data and the header. Returns false
+    // on a write error.
+    bool finish()
+    {
+        game_offsets_.push_back(game_bytes_);
+        pad();
+        header_.game_index = std::uint64_t(std::ftell(out_));
+        std::fwrite(game_offsets_.data(), 8, game_offsets_.size(), out_);
+        header_.games = game_offsets_.size() - 1;
+
+        spill();
+        pad();
+        header_.posting_list = std::uint64_t(std::ftell(out_));
+        std::FILE* records = std::tmpfile();
+        if (!records)
+            return false;
+        std::vector<std::uint64_t> buckets((1u << c4::DB_BUCKET_BITS) + 1, 0);
+        merge(records, buckets);
+
+        pad();
+        header_.buckets = std::uint64_t(std::ftell(out_));
+        std::fwrite(buckets.data(), 8, buckets.size(), out_);
+
+        header_.records = std::uint64_t(std::ftell(out_));
+        std::rewind(records);
+        char buf[1 << 16];
+        std::size_t n;
+        while ((n = std::fread(buf, 1, sizeof buf, records)) > 0)
+            std::fwrite(buf, 1, n, out_);
+        std::fclose(records);
+
+        std::memcpy(header_.magic, c4::DB_MAGIC, sizeof header_.magic);
+        header_.version = c4::DB_VERSION;
+        header_.bucket_bits = c4::DB_BUCKET_BITS;
+        std::rewind(out_);
+        std::fwrite(&header_, sizeof header_, 1, out_);
+        return std::fflush(out_) == 0 && !std::ferror(out_);
+    }
+
+    const c4::DbHeader& header() const { return header_; }
+
+private:
+    // One sorted run on disk, read back a block at a time.
+    struct Run {
+        std::FILE* file;
+        std::vector<Entry> block;
+        std::size_t pos = 0;
+
+        bool next(Entry& e)
+        {
+            if (pos == block.size()) {
+                block.resize(4096);
+                block.resize(std::fread(block.data(), sizeof(Entry), block.size(), file));
+                pos = 0;
+                if (block.empty())
+                    return false;
+            }
+            e = block[pos++];
+            return true;
+        }
+    };
+
+    void push(const Entry& e)
+    {
+        run_.push_back(e);
+        if (run_.size() >= run_limit_)
+            spill();
+    }
+
+    void spill()
+    {
+        if (run_.empty())
+            return;
+        std::sort(run_.begin(), run_.end(), entry_less);
+        std::FILE* f = std::tmpfile();
+        if (!f) {
+            std::perror("c4db: temporary file");
+            std::exit(1);
+        }
+        std::fwrite(run_.data(), sizeof(Entry), run_.size(), f);
+        std::rewind(f);
+        runs_.push_back({ f, {}, 0 });
+        run_.clear();
+    }
+
+    // Merges the runs into postings (straight to the output) and records
+    // (to a temporary file, they go last), filling in the bucket starts.
+    void merge(std::FILE* records, std::vector<std::uint64_t>& buckets)
+    {
+        using Head = std::pair<Entry, std::size_t>;
+        auto later = [](const Head& a, const Head& b) { return entry_less(b.first, a.first); };
+        std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+        for (std::size_t i = 0; i < runs_.size(); i++) {
+            Entry e;
+            if (runs_[i].next(e))
+                heads.push({ e, i });
+        }
+
+        std::uint64_t positions = 0;
+        std::uint64_t postings = 0;
+        std::vector<std::uint32_t> out;
+        bool open = false;
+        c4::DbRecord rec {};
+        std::uint32_t last_game = 0;
+        std::size_t next_bucket = 0; // first bucket with no start yet
+
+        auto close_record = [&] {
+            if (!open)
+                return;
+            std::fwrite(&rec, sizeof rec, 1, records);
+            positions++;
+            open = false;
+        };
+
+        while (!heads.empty()) {
+            Head h = heads.top();
+            heads.pop();
+            const Entry& e = h.first;
+
+            if (!open || !(rec.key == e.key)) {
+                close_record();
+                // this record starts its bucket and any empty ones before it
+                std::size_t bucket = std::size_t(e.hash >> (64 - c4::DB_BUCKET_BITS));
+                while (next_bucket <= bucket)
+                    buckets[next_bucket++] = positions;
+                rec = {};
+                rec.key = e.key;
+                rec.first_posting = postings;
+                open = true;
+                last_game = VALUE_ENTRY;
+            }
+
+            if (e.game == VALUE_ENTRY) {
+                rec.value = std::int16_t(std::max(-32768, std::min(32767, e.value)));
+                rec.flags |= c4::DB_HAS_VALUE;
+            } else if (e.game != last_game) {
+                out.push_back(e.game);
+                rec.posting_count++;
+                postings++;
+                last_game = e.game;
+                if (out.size() == 4096) {
+                    std::fwrite(out.data(), 4, out.size(), out_);
+                    out.clear();
+                }
+            }
+
+            Entry next;
+            if (runs_[h.second].next(next))
+                heads.push({ next, h.second });
+        }
+        close_record();
+        std::fwrite(out.data(), 4, out.size(), out_);
+
+        // the buckets after the last record, and the end marker
+        while (next_bucket < buckets.size())
+            buckets[next_bucket++] = positions;
+
+        for (auto& r : runs_)
+            std::fclose(r.file);
+        runs_.clear();
+        header_.positions = positions;
+        header_.postings = postings;
+    }
+
+    void pad()
+    {
+        static const char zeros[8] = {};
+        long at = std::ftell(out_);
+        if (at % 8)
+            std::fwrite(zeros, 1, std::size_t(8 - at % 8), out_);
+    }
+
+    std::FILE* out_;
+    std::size_t run_limit_;
+    c4::DbHeader header_;
+    std::vector<Entry> run_;
+    std::vector<Run> runs_;
+    std::vector<std::uint64_t> game_offsets_;
+    std::uint64_t game_bytes_ = 0;
+};
+
+bool parse_size(const std::string& s, unsigned& w, unsigned& h)
+{
+    return std::sscanf(s.c_str(), "%ux%u", &w, &h) == 2;
+}
+
+// Digits, optionally after the side that moved first ("O 3344"), X if not
+// given.
+bool parse_moves(const std::string& s, std::vector<std::uint8_t>& moves, c4::Player& first)
+{
+    moves.clear();
+    first = c4::X;
+    for (char c : s) {
+        if (c >= '0' && c <= '8')
+            moves.push_back(std::uint8_t(c - '0'));
+        else if ((c == 'X' || c == 'O') && moves.empty())
+            first = c == 'X' ? c4::X : c4::O;
+        else if (c != ' ' && c != '\t' && c != ',')
+            return false;
+    }
+    return true;
+}
+
+// Text input. Returns the number of lines refused.
+unsigned long read_text(std::istream& in, const char* name, Builder& db)
+{
+    unsigned long refused = 0;
+    unsigned long line_no = 0;
+    std::string line;
+    std::vector<std::uint8_t> moves;
+    c4::Player first;
+    Replay r;
+
+    while (std::getline(in, line)) {
+        line_no++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::size_t space = line.find(' ');
+        std::size_t eq = line.find('=');
+        unsigned w, h;
+        std::string move_text = line.substr(space == std::string::npos ? line.size() : space + 1,
+            eq == std::string::npos ? std::string::npos : eq - space - 1);
+        if (!parse_size(line.substr(0, space), w, h) || !parse_moves(move_text, moves, first) || !replay(w, h, first, moves, r)) {
+            if (refused++ < 10)
+                std::fprintf(stderr, "c4db: %s:%lu: not a legal game: %s\n", name, line_no, line.c_str());
+            continue;
+        }
+
+        if (eq != std::string::npos)
+            db.add_value(r.keys.back(), std::atoi(line.c_str() + eq + 1));
+        else
+            db.add_game(r, moves);
+    }
+    return refused;
+}
+
+// Binary captures. Returns the number of games refused.
+unsigned long read_frames(std::istream& in, Builder& db)
+{
+    unsigned long refused = 0;
+    unsigned w = 0, h = 0;
+    bool in_game = false;
+    bool known_first = false; // from MSG_NEW_GAME, else the first move
+    bool bad = false;
+    c4::Player first = c4::X;
+    std::uint8_t heights[9] = {};
+    std::vector<std::uint8_t> moves;
+    Replay r;
+
+    auto end_game = [&] {
+        if (in_game && !moves.empty()) {
+            if (!bad && replay(w, h, first, moves, r))
+                db.add_game(r, moves);
+            else
+                refused++;
+        }
+        in_game = false;
+        moves.clear();
+    };
+
+    c4::FrameParser parser;
+    parser.on_frame = [&](const c4::Frame& f) {
+        const std::uint8_t* p = f.payload;
+        if (f.type == MSG_NEW_GAME && f.length >= 2) {
+            end_game();
+            w = p[0];
+            h = p[1];
+            known_first = f.length >= 3 && (p[2] == 'X' || p[2] == 'O');
+            first = known_first && p[2] == 'O' ? c4::O : c4::X;
+            bad = f.length >= 3 && !known_first;
+            std::fill(std::begin(heights), std::end(heights), 0);
+            in_game = true;
+        } else if (f.type == MSG_MOVE && in_game) {
+            if (f.length < 4 || p[0] >= 9) {
+                bad = true;
+                return;
+            }
+            if (moves.empty() && !known_first)
+                first = p[2] == 'O' ? c4::O : c4::X;
+            c4::Player mover = moves.size() % 2 ? c4::other(first) : first;
+            // the piece is the one the replay puts there, in the row it
+            // lands in, and the side to move follows from it; several
+            // moves in one drawing all carry the side to move after the
+            // last, which is the piece's own for at least one of them
+            if (p[1] != heights[p[0]]++ || p[2] != c4::piece_char(mover) || p[3] != c4::piece_char(c4::other(mover)))
+                bad = true;
+            moves.push_back(p[0]);
+        } else if (f.type == MSG_RESULT || f.type == MSG_SELECT) {
+            end_game();
+        }
+    };
+
+    char buf[1 << 16];
+    while (in.read(buf, sizeof buf) || in.gcount() > 0)
+        parser.feed(reinterpret_cast<const std::uint8_t*>(buf), std::size_t(in.gcount()));
+    end_game();
+    return refused;
+}
+
+int build(int argc, char** argv)
+{
+    bool frames = false;
+    std::size_t memory_mb = 1024;
+    std::vector<const char*> files;
+    for (int i = 0; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--frames"))
+            frames = true;
+        else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+            memory_mb = std::size_t(std::strtoul(argv[++i], nullptr, 10));
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage: c4db build [--frames] [-m MB] out.db [input...]\n");
+        return 2;
+    }
+
+    const char* path = files[0];
+    files.erase(files.begin());
+    std::FILE* out = std::fopen(path, "w+b");
+    if (!out) {
+        std::perror(path);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Builder db(out, std::max<std::size_t>(1, memory_mb * 1024 * 1024 / sizeof(Entry)));
+    unsigned long refused = 0;
+    if (files.empty()) {
+        refused += frames ? read_frames(std::cin, db) : read_text(std::cin, "stdin", db);
+    } else {
+        for (const char* f : files) {
+            std::ifstream in(f, std::ios::binary);
+            if (!in) {
+                std::perror(f);
+                return 1;
+            }
+            refused += frames ? read_frames(in, db) : read_text(in, f, db);
+        }
+    }
+
+    if (!db.finish()) {
+        std::fprintf(stderr, "c4db: %s: write failed\n", path);
+        return 1;
+    }
+    std::fclose(out);
+
+    std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+    const c4::DbHeader& hd = db.header();
+    std::printf("%llu games, %llu positions, %llu postings in %.1f s, %lu refused\n", (unsigned long long)hd.games,
+        (unsigned long long)hd.positions, (unsigned long long)hd.postings, took.count(), refused);
+    return 0;
+}
+
+// Looks up the position after moves. Returns the record or nullptr.
+const c4::DbRecord* lookup(const c4::GameDb& db, const char* size, const char* move_text, double& micros)
+{
+    unsigned w, h;
+    std::vector<std::uint8_t> moves;
+    c4::Player first;
+    Replay r;
+    if (!parse_size(size, w, h) || !parse_moves(move_text, moves, first) || !replay(w, h, first, moves, r)) {
+        std::fprintf(stderr, "c4db: %s %s is not a legal position\n", size, move_text);
+        std::exit(2);
+    }
+    auto start = std::chrono::steady_clock::now();
+    const c4::DbRecord* rec = db.find(r.keys.back());
+    std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+    micros = took.count();
+    return rec;
+}
+
+// Builds a database from captures made up here and checks which games it
+// kept, and that they kept who moved first. Returns the exit status.
+int self_test()
+{
+    std::string capture;
+    auto frame = [&](std::uint8_t type, const std::vector<std::uint8_t>& payload) {
+        c4::encode_frame(capture, type, payload.data(), std::uint8_t(payload.size()));
+    };
+    // A game as the board sends it, the first move by first, and the last
+    // `together` moves in one drawing, column by column.
+    auto game = [&](const std::vector<std::uint8_t>& new_game, char first, const std::string& cols, std::size_t together) {
+        struct Cell {
+            std::uint8_t col, row;
+            char piece;
+        };
+        std::vector<Cell> cells;
+        std::uint8_t heights[9] = {};
+        char p = first;
+        for (char c : cols) {
+            std::uint8_t col = std::uint8_t(c - '0');
+            cells.push_back({ col, heights[col]++, p });
+            p = p == 'X' ? 'O' : 'X';
+        }
+        std::size_t alone = cells.size() - together;
+        std::sort(cells.begin() + std::ptrdiff_t(alone), cells.end(),
+            [](const Cell& a, const Cell& b) { return a.col != b.col ? a.col < b.col : a.row < b.row; });
+
+        frame(MSG_NEW_GAME, new_game);
+        for (std::size_t i = 0; i < cells.size(); i++) {
+            char next = i < alone ? (cells[i].piece == 'X' ? 'O' : 'X') : p;
+            frame(MSG_MOVE, { cells[i].col, cells[i].row, std::uint8_t(cells[i].piece), std::uint8_t(next) });
+        }
+        frame(MSG_RESULT, { std::uint8_t(' ') });
+    };
+
+    game({ 7, 6, 'O' }, 'O', "3344556", 0); // O first, wins along the bottom
+    game({ 7, 6, 'X' }, 'X', "3344556", 2); // last two moves in one drawing
+    game({ 7, 6, 'X' }, 'O', "3344", 0);    // pieces disagree with the header
+    game({ 7, 6 }, 'O', "3322", 0);         // older firmware, side from the pieces
+
+    char path[] = "/tmp/c4dbtestXXXXXX";
+    int fd = mkstemp(path);
+    std::FILE* out = fd < 0 ? nullptr : fdopen(fd, "w+b");
+    if (!out) {
+        std::perror("c4db test");
+        return 1;
+    }
+    Builder b(out, 1 << 16);
+    std::istringstream in(capture);
+    unsigned long refused = read_frames(in, b);
+    bool written = b.finish();
+    std::fclose(out);
+
+    c4::GameDb db;
+    bool opened = written && db.open(path);
+    unlink(path);
+    if (!opened) {
+        std::fprintf(stderr, "c4db test: %s\n", written ? db.error().c_str() : "write failed");
+        return 1;
+    }
+
+    int failures = 0;
+    auto check = [&](bool ok, const char* what) {
+        if (!ok) {
+            std::fprintf(stderr, "c4db test: FAIL %s\n", what);
+            failures++;
+        }
+    };
+    auto moves_of = [&](const c4::DbGame& g) { return std::string(g.moves, g.moves + g.move_count); };
+    check(db.header().games == 2 && refused == 2, "two games kept and two refused");
+    if (db.header().games == 2) {
+        c4::DbGame g = db.game(0);
+        check(g.first == 'O' && g.result == 'O' && moves_of(g) == std::string("\3\3\4\4\5\5\6"), "O first game kept as played");
+        g = db.game(1);
+        check(g.first == 'O' && g.result == '?' && g.move_count == 4, "side taken from the first piece");
+    }
+    double micros;
+    check(lookup(db, "7x6", "O 3", micros) != nullptr, "position with O in the middle found");
+    check(lookup(db, "7x6", "X 3", micros) == nullptr, "position with X in the middle not stored");
+
+    if (failures)
+        return 1;
+    std::printf("c4db test: ok\n");
+    return 0;
+}
+
+void print_results(const c4::GameDb& db, const c4::DbRecord& rec)
+{
+    unsigned long x = 0, o = 0, draws = 0, open = 0;
+    const std::uint32_t* games = db.postings(rec);
+    for (std::uint32_t i = 0; i < rec.posting_count; i++) {
+        char r = db.game(games[i]).result;
+        x += r == 'X';
+        o += r == 'O';
+        draws += r == ' ';
+        open += r == '?';
+    }
+    std::printf("%u games: X won %lu, O won %lu, %lu draws, %lu unfinished\n", rec.posting_count, x, o, draws, open);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2 && !std::strcmp(argv[1], "build"))
+        return build(argc - 2, argv + 2);
+    if (argc >= 2 && !std::strcmp(argv[1], "test"))
+        return self_test();
+
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: c4db build [--frames] [-m MB] out.db [input...]\n"
+                             "       c4db info db\n"
+                             "       c4db games db WxH moves [-n max]\n"
+                             "       c4db value db WxH moves\n"
+                             "       c4db test\n");
+        return 2;
+    }
+
+    c4::GameDb db;
+    if (!db.open(argv[2])) {
+        std::fprintf(stderr, "c4db: %s\n", db.error().c_str());
+        return 1;
+    }
+
+    if (!std::strcmp(argv[1], "info")) {
+        const c4::DbHeader& h = db.header();
+        std::printf("%llu games, %llu positions, %llu postings, %zu bytes\n", (unsigned long long)h.games,
+            (unsigned long long)h.positions, (unsigned long long)h.postings, db.file_size());
+        return 0;
+    }
+
+    if (argc < 5) {
+        std::fprintf(stderr, "c4db: %s needs a size and moves\n", argv[1]);
+        return 2;
+    }
+    double micros = 0;
+    const c4::DbRecord* rec = lookup(db, argv[3], argv[4], micros);
+
+    if (!std::strcmp(argv[1], "value")) {
+        if (!rec) {
+            std::printf("not stored (%.1f us)\n", micros);
+            return 1;
+        }
+        if (rec->flags & c4::DB_HAS_VALUE)
+            std::printf("value %d\n", rec->value);
+        else
+            std::printf("no value stored\n");
+        print_results(db, *rec);
+        std::printf("(%.1f us)\n", micros);
+        return 0;
+    }
+
+    if (!std::strcmp(argv[1], "games")) {
+        unsigned long max = 20;
+        if (argc >= 7 && !std::strcmp(argv[5], "-n"))
+            max = std::strtoul(argv[6], nullptr, 10);
+        if (!rec || !rec->posting_count) {
+            std::printf("no games (%.1f us)\n", micros);
+            return 1;
+        }
+        print_results(db, *rec);
+        const std::uint32_t* games = db.postings(*rec);
+        for (std::uint32_t i = 0; i < rec->posting_count && i < max; i++) {
+            c4::DbGame g = db.game(games[i]);
+            std::string moves = g.first == 'O' ? "O " : "";
+            for (std::size_t m = 0; m < g.move_count; m++)
+                moves += char('0' + g.moves[m]);
+            std::printf("%8u  %ux%u %c  %s\n", games[i], g.width, g.height, g.result == ' ' ? '=' : g.result, moves.c_str());
+        }
+        std::printf("(%.1f us)\n", micros);
+        return 0;
+    }
+
+    std::fprintf(stderr, "c4db: unknown command %s\n", argv[1]);
+    return 2;
+}
@@ -0,0 +1,175 @@
+// c4view - terminal renderer for the board's binary output mode.
+//
+// Reads the frame stream described in src/proto.h from a serial port (or
+// stdin) and draws the board locally, so the firmware only has to send a
+// few bytes per move instead of the whole board as text art.
+//
+// Build: g++ -std=c++17 -O2 -o c4view host/c4view.cpp
+// Usage: c4view [-b baud] [device]       (default 9600, stdin)
+
+#include "protocol.hpp"
+#include "serial.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+class BoardView {
+public:
+    void select()
+    {
+        width_ = 0;
+        status_ = "Choose a size on the board";
+        redraw();
+    }
+
+    void new_game(int width, int height, char first)
+    {
+        width_ = width;
+        height_ = height;
+        cells_.assign(std::size_t(width * height), ' ');
+        status_ = std::string(1, first) + " to move";
+        redraw();
+    }
+
+    void move(int col, int row, char piece, char next)
+    {
+        if (col < 0 || col >= width_ || row < 0 || row >= height_)
+            return;
+        cells_[std::size_t(col * height_ + row)] = piece;
+        status_ = std::string(1, next) + " to move";
+        redraw();
+    }
+
+    void result(char winner)
+    {
+        if (winner == ' ')
+            status_ = "There was a draw! Good luck next time. Hit any button to try again.";
+        else
+            status_ = std::string(1, winner) + " wins! Press any button to play another game.";
+        redraw();
+    }
+
+    void link(int last_ms, int worst_ms, int resends)
+    {
+        status_ += "\r\nLink: " + std::to_string(last_ms) + " ms, worst " + std::to_string(worst_ms) + " ms, resends " + std::to_string(resends);
+        redraw();
+    }
+
+    void text(std::uint8_t c)
+    {
+        // Plain text between frames is passed straight through.
+        std::fputc(c, stdout);
+        std::fflush(stdout);
+    }
+
+private:
+    // Same layout as board_draw() in the firmware.
+    void redraw()
+    {
+        std::string out = "\033[2J\033[H";
+        int length = 2 * width_ + 1;
+        int height = 2 * height_ + 1;
+
+        for (int j = 0; width_ && j < height; j++) {
+            for (int i = 0; i < length; i++) {
+                if (j % 2 == 0)
+                    out += (i % 2 == 0) ? '+' : '-';
+                else if (i % 2 == 0)
+                    out += '|';
+                else
+                    out += cells_[std::size_t((i / 2) * height_ + (height_ - 1 - j / 2))];
+            }
+            out += "\r\n";
+        }
+        out += status_;
+        out += "\r\n";
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<char> cells_;
+    std::string status_;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long baud = 9600;
+    const char* device = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            baud = std::strtol(argv[++i], nullptr, 10);
+        else
+            device = argv[i];
+    }
+
+    if (!c4::to_speed(baud)) {
+        std::fprintf(stderr, "c4view: unsupported baud rate %ld\n", baud);
+        return 2;
+    }
+
+    int fd = STDIN_FILENO;
+    if (device) {
+        fd = c4::open_serial(device, baud);
+        if (fd < 0) {
+            std::fprintf(stderr, "c4view: %s: %s\n", device, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    BoardView view;
+    c4::FrameParser parser;
+    parser.on_text = [&](std::uint8_t c) { view.text(c); };
+    parser.on_frame = [&](const c4::Frame& f) {
+        const std::uint8_t* p = f.payload;
+        switch (f.type) {
+        case MSG_SELECT:
+            view.select();
+            break;
+        case MSG_NEW_GAME:
+            if (f.length >= 3)
+                view.new_game(p[0], p[1], char(p[2]));
+            break;
+        case MSG_MOVE:
+            if (f.length >= 4)
+                view.move(p[0], p[1], char(p[2]), char(p[3]));
+            break;
+        case MSG_RESULT:
+            if (f.length >= 1)
+                view.result(char(p[0]));
+            break;
+        case MSG_LINK:
+            if (f.length >= 6)
+                view.link(p[0] << 8 | p[1], p[2] << 8 | p[3], p[4] << 8 | p[5]);
+            break;
+        default:
+            break;
+        }
+    };
+
+    std::uint8_t buf[256];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof buf);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        parser.feed(buf, std::size_t(n));
+    }
+
+    if (parser.crc_errors)
+        std::fprintf(stderr, "c4view: %zu frames, %zu dropped on bad CRC\n", parser.frames, parser.crc_errors);
+    return 0;
+}
@@ -0,0 +1,21 @@
+// The firmware headers the host tools share, in one place.
+//
+// Firmware headers use the Keil C51 memory classes (code, data, xdata...),
+// which src/compiler.h defines away for other compilers. Those names clash
+// with the C++ library (std::data for one), so they are undefined again
+// right after. Include this instead of the headers in src/.
+#pragma once
+
+extern "C" {
+#include "../src/compiler.h"
+#include "../src/config.h"
+#include "../src/proto.h"
+#include "../src/tick.h"
+#include "../src/trace.h"
+#include "../src/uart.h"
+}
+
+#undef code
+#undef data
+#undef idata
+#undef xdata
@@ -0,0 +1,230 @@
+// Game database: archived games and stored position values in one file,
+// read in place through mmap.
+//
+// Positions are keyed by their exact contents, folded onto the smaller of
+// a board and its left-right mirror image, so a position and its mirror
+// share one record. Records are sorted by a hash of the key and found
+// through a table of 2^16 buckets on the top bits of the hash, then a
+// binary search inside the bucket, touching a few pages however big the
+// file is. Each record points at the list of games that pass through it.
+//
+// Layout, little endian, sections found through the header and 8 byte
+// aligned, in the order host/c4db.cpp streams them out:
+//   DbHeader
+//   game data    per game: geometry (width << 4 | height), result ('X',
+//                'O', ' ' for a draw, '?' unfinished), the side that
+//                moved first ('X' or 'O'), then the columns
+//   game index   u64[games + 1]    offsets of each game in the game data
+//   postings     u32[postings]     game numbers, each record's in order
+//   buckets      u64[2^16 + 1]     first record of each bucket
+//   records      DbRecord[positions], sorted by (hash, key)
+//
+// Written by host/c4db.cpp.
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace c4 {
+
+// A position: 4 bits each of width and height, then for each column 4
+// bits of height and 8 bits with the X pieces, 116 bits in all.
+struct PosKey {
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+
+    bool operator==(const PosKey& o) const { return hi == o.hi && lo == o.lo; }
+    bool operator<(const PosKey& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+};
+
+// Builds a key from per-column heights and X masks (O fills the rest of
+// each column), mirrored or not.
+inline PosKey make_key(unsigned width, unsigned height, const std::uint8_t* heights, const std::uint8_t* x_cols, bool mirror)
+{
+    unsigned __int128 k = (unsigned __int128)(width << 4 | height);
+    for (unsigned i = 0; i < width; i++) {
+        unsigned c = mirror ? width - 1 - i : i;
+        k = k << 12 | (unsigned __int128)(heights[c] << 8 | x_cols[c]);
+    }
+    PosKey key;
+    key.hi = std::uint64_t(k >> 64);
+    key.lo = std::uint64_t(k);
+    return key;
+}
+
+// The key a position and its mirror image are both stored under.
+inline PosKey canonical_key(unsigned width, unsigned height, const std::uint8_t* heights, const std::uint8_t* x_cols)
+{
+    PosKey a = make_key(width, height, heights, x_cols, false);
+    PosKey b = make_key(width, height, heights, x_cols, true);
+    return b < a ? b : a;
+}
+
+inline std::uint64_t key_hash(const PosKey& k)
+{
+    std::uint64_t h = k.hi * 0x9E3779B97F4A7C15ull ^ k.lo;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 29;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 32);
+}
+
+constexpr unsigned DB_BUCKET_BITS = 16;
+constexpr std::uint32_t DB_VERSION = 2;
+constexpr char DB_MAGIC[8] = { 'C', '4', 'G', 'A', 'M', 'E', 'D', 'B' };
+
+// Record flags
+constexpr std::uint16_t DB_HAS_VALUE = 1;
+
+struct DbHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t bucket_bits;
+    std::uint64_t games;
+    std::uint64_t positions;
+    std::uint64_t postings;
+    std::uint64_t game_index; // file offsets of the sections
+    std::uint64_t game_data;
+    std::uint64_t buckets;
+    std::uint64_t records;
+    std::uint64_t posting_list;
+};
+
+struct DbRecord {
+    PosKey key;
+    std::uint64_t first_posting;
+    std::uint32_t posting_count;
+    std::int16_t value; // stored evaluation, if DB_HAS_VALUE
+    std::uint16_t flags;
+};
+static_assert(sizeof(DbRecord) == 32, "records are 32 bytes on disk");
+
+struct DbGame {
+    unsigned width = 0;
+    unsigned height = 0;
+    char result = '?';
+    char first = 'X';
+    const std::uint8_t* moves = nullptr;
+    std::size_t move_count = 0;
+};
+
+// Read-only view of a database file.
+class GameDb {
+public:
+    GameDb() = default;
+    GameDb(const GameDb&) = delete;
+    GameDb& operator=(const GameDb&) = delete;
+    ~GameDb() { close(); }
+
+    // Maps the file. Returns false, with error() set, if it is not a
+    // database this code can read.
+    bool open(const char* path)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return fail(std::string(path) + ": " + std::strerror(errno));
+        struct stat st;
+        if (fstat(fd, &st) < 0 || std::size_t(st.st_size) < sizeof(DbHeader)) {
+            ::close(fd);
+            return fail(std::string(path) + ": too short");
+        }
+        size_ = std::size_t(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return fail(std::string(path) + ": " + std::strerror(errno));
+        base_ = static_cast<const std::uint8_t*>(p);
+        // lookups jump around, read ahead would only waste page cache
+        madvise(p, size_, MADV_RANDOM);
+
+        header_ = reinterpret_cast<const DbHeader*>(base_);
+        if (std::memcmp(header_->magic, DB_MAGIC, sizeof DB_MAGIC) || header_->version != DB_VERSION
+            || header_->bucket_bits != DB_BUCKET_BITS)
+            return fail(std::string(path) + ": not a game database of this version");
+        if (!inside(header_->game_index, (header_->games + 1) * 8) || !inside(header_->buckets, ((1ull << DB_BUCKET_BITS) + 1) * 8)
+            || !inside(header_->records, header_->positions * sizeof(DbRecord)) || !inside(header_->posting_list, header_->postings * 4))
+            return fail(std::string(path) + ": truncated");
+
+        game_index_ = reinterpret_cast<const std::uint64_t*>(base_ + header_->game_index);
+        buckets_ = reinterpret_cast<const std::uint64_t*>(base_ + header_->buckets);
+        records_ = reinterpret_cast<const DbRecord*>(base_ + header_->records);
+        postings_ = reinterpret_cast<const std::uint32_t*>(base_ + header_->posting_list);
+        return true;
+    }
+
+    void close()
+    {
+        if (base_)
+            munmap(const_cast<std::uint8_t*>(base_), size_);
+        base_ = nullptr;
+        header_ = nullptr;
+    }
+
+    const std::string& error() const { return error_; }
+    const DbHeader& header() const { return *header_; }
+    std::size_t file_size() const { return size_; }
+
+    // The record for a canonical key, nullptr if the position is not stored.
+    const DbRecord* find(const PosKey& key) const
+    {
+        std::uint64_t h = key_hash(key);
+        std::uint64_t b = h >> (64 - DB_BUCKET_BITS);
+        const DbRecord* first = records_ + buckets_[b];
+        const DbRecord* last = records_ + buckets_[b + 1];
+        const DbRecord* r = std::lower_bound(first, last, std::make_pair(h, key), [](const DbRecord& rec, const std::pair<std::uint64_t, PosKey>& want) {
+            std::uint64_t rh = key_hash(rec.key);
+            return rh != want.first ? rh < want.first : rec.key < want.second;
+        });
+        return r != last && r->key == key ? r : nullptr;
+    }
+
+    // Game numbers of the games through a record's position.
+    const std::uint32_t* postings(const DbRecord& r) const { return postings_ + r.first_posting; }
+
+    DbGame game(std::uint64_t n) const
+    {
+        DbGame g;
+        const std::uint8_t* p = base_ + header_->game_data + game_index_[n];
+        std::size_t length = std::size_t(game_index_[n + 1] - game_index_[n]);
+        g.width = p[0] >> 4;
+        g.height = p[0] & 15;
+        g.result = char(p[1]);
+        g.first = char(p[2]);
+        g.moves = p + 3;
+        g.move_count = length - 3;
+        return g;
+    }
+
+private:
+    bool fail(const std::string& why)
+    {
+        close();
+        error_ = why;
+        return false;
+    }
+
+    bool inside(std::uint64_t offset, std::uint64_t length) const { return offset <= size_ && length <= size_ - offset; }
+
+    const std::uint8_t* base_ = nullptr;
+    std::size_t size_ = 0;
+    const DbHeader* header_ = nullptr;
+    const std::uint64_t* game_index_ = nullptr;
+    const std::uint64_t* buckets_ = nullptr;
+    const DbRecord* records_ = nullptr;
+    const std::uint32_t* postings_ = nullptr;
+    std::string error_;
+};
+
+} // namespace c4
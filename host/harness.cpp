@@ -0,0 +1,549 @@
+// harness - differential test and timing of the rules engines.
+//
+// Plays every reachable game up to a given number of moves on each board
+// size and checks, after every button press, that every engine agrees on
+// where the piece lands (or that it is refused), whether X or O has four
+// in a row and whether the board is a draw. After every move that does
+// not end the game it also checks the firmware's threat tracking
+// (src/threat.c), which only follows moves, against a full rescan: a
+// trial drop and check_win() in every column for each side. The engines
+// are:
+//
+//   legacy     check_win(), draw() and the drop loop of player_turn() from
+//              the original firmware, copied unchanged below. They only
+//              know the original sizes, 5x4, 6x5 and 7x6 (board[7][6]),
+//              and are the reference wherever they apply.
+//   rules.c    the firmware's engine, src/rules.c compiled in.
+//   rules.hpp  the host template, c4::Board<W, H>.
+//
+// To try a faster engine, add an Engine for it to engines_for() below.
+//
+// The search deepens one move at a time, so the first mismatch reported
+// comes with the shortest move sequence that shows it. Every engine is
+// then timed walking the same game tree.
+//
+// Build: g++ -std=c++17 -O2 -o harness host/harness.cpp
+// Usage: harness [-d depth] [-g WxH]       (default depth 6, every size)
+//
+// Exits with 1 on the first mismatch.
+
+#include "rules.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace legacy {
+
+// From the original src/connect-four.c, unchanged but for the button loop
+// of player_turn(), which legacy_drop() below stands in for.
+
+const unsigned char SPACE_X = 'X';
+const unsigned char SPACE_O = 'O';
+const unsigned char SPACE_EMPTY = ' ';
+
+// Board used for connect-four
+unsigned char board[7][6];
+unsigned char size;
+
+/*
+    Desc: Check if there is a draw between players.
+    @params: none
+**/
+unsigned char draw()
+{
+    // i and j are used to iterate over the board.
+	unsigned char i;
+	unsigned char j;
+	unsigned char draw = 1;
+
+	for (i = 0; i < size; i++)
+	{
+		for (j = 0; j < size - 1; j++)
+		{
+		    // If there is an available spot to place
+		    // there is no draw so set draw = 0 (false)
+			if (board[i][j] == SPACE_EMPTY)
+			{
+				draw = 0;
+			}
+		}
+	}
+	return draw;
+}
+
+/*
+    Desc: Fill the board with spaces (' ')
+    @params: none
+**/
+void board_construct()
+{
+	unsigned char i;
+	unsigned char j;
+    // Iterate over the board with the selected player size in mind and fill with spaces.
+	for (i = 0; i < size; i++)
+	{
+		for (j = 0; j < size - 1; j++)
+		{
+			board[i][j] = SPACE_EMPTY;
+		}
+	}
+}
+
+/*
+    Desc: check_win checks if a player has any 4 in a row. It checks diagonal
+          and like a cross.
+    @params: char player - To check the correct character (X/O) and see if 4 in a row.
+**/
+unsigned char check_win(unsigned char player)
+{
+	unsigned char i;
+	unsigned char j;
+	unsigned char iw;
+	unsigned char jw;
+
+	// iterate through every space to check
+	for (i = 0; i < size; i++)
+	{
+    	for (j = 0; j < size-1; j++)
+		{
+
+			// fast continue if this space isn't the player
+			if (board[i][j] != player) continue;
+
+			// horizontal check
+			if (i < size-3)
+			{
+				iw = 1; // already checked the 0th space
+				while (board[i+iw][j] == player)
+				{
+					if (iw >= 3) return 1;
+					iw++;
+				}
+
+			}
+
+			// vertical check
+			if (j < size-4)
+			{
+				jw = 1;
+				while (board[i][j+jw] == player)
+				{
+					if (jw >= 3) return 1;
+					jw++;
+				}
+
+			}
+
+			// positive diagonal check
+			if (i < size-3 && j < size-4)
+			{
+				iw = 1;
+				jw = 1;
+
+				while (board[i+iw][j+jw] == player)
+				{
+					if (iw >= 3) return 1;
+					iw++;
+					jw++;
+				}
+			}
+
+			// negative diagonal check
+			if (i < size-3 && j >= 3)
+			{
+				iw = 1;
+				jw = 1;
+
+				while (board[i+iw][j-jw] == player) // note the minus
+				{
+					if (iw >= 3) return 1;
+					iw++;
+					jw++;
+				}
+			}
+
+
+	    }
+	}
+
+	return 0;
+}
+
+// player_turn() after a press of button i: the check that makes it wait
+// for another press, then the placing loop. Returns the row, or -1 where
+// player_turn() would have waited.
+int legacy_drop(unsigned char i, unsigned char player)
+{
+	unsigned char j;
+
+	// keep looping on two conditions
+	// 1. The pressed button is at an i too wide for the current board size
+	// 2. The column is full of pieces already (the top slot isn't empty)
+	if (i >= size || board[i][size-2] != SPACE_EMPTY) return -1;
+
+	// place piece
+	for (j = 0; j < size-1; j++)
+	{
+		if (board[i][j] == SPACE_EMPTY)
+		{
+			board[i][j] = player;
+			break;
+		}
+	}
+	return j;
+}
+
+} // namespace legacy
+
+// The firmware engine. firmware.hpp has already undefined the memory
+// classes for the C++ headers, so they are defined away again around it.
+extern "C" {
+#define code
+#define data
+#define idata
+#define xdata
+#include "../src/rules.c"
+#include "../src/threat.c"
+#undef code
+#undef data
+#undef idata
+#undef xdata
+}
+
+namespace {
+
+constexpr unsigned BUTTONS = 9;
+
+char piece(c4::Player p) { return c4::piece_char(p); }
+
+// One rules engine, for the comparison. The timing calls the concrete
+// classes directly so the virtual calls do not count.
+struct Engine {
+    virtual ~Engine() = default;
+    virtual const char* name() const = 0;
+    virtual void reset() = 0;
+    // Row the piece lands in, -1 if refused.
+    virtual int drop(unsigned button, c4::Player p) = 0;
+    virtual void undo(unsigned col) = 0;
+    virtual bool wins(c4::Player p) = 0;
+    virtual bool draw() = 0;
+};
+
+struct Legacy final : Engine {
+    explicit Legacy(unsigned w) { legacy::size = (unsigned char)w; }
+    const char* name() const override { return "legacy"; }
+    void reset() override { legacy::board_construct(); }
+    int drop(unsigned button, c4::Player p) override { return legacy::legacy_drop((unsigned char)button, (unsigned char)piece(p)); }
+    void undo(unsigned col) override
+    {
+        // the original never took a piece back; empty the top cell
+        int j = legacy::size - 2;
+        while (j > 0 && legacy::board[col][j] == ' ')
+            j--;
+        legacy::board[col][j] = ' ';
+    }
+    bool wins(c4::Player p) override { return legacy::check_win((unsigned char)piece(p)); }
+    bool draw() override { return legacy::draw(); }
+};
+
+struct Firmware final : Engine {
+    explicit Firmware(unsigned geom) { rules_select((unsigned char)geom); }
+    const char* name() const override { return "rules.c"; }
+    void reset() override { board_construct(); }
+    int drop(unsigned button, c4::Player p) override
+    {
+        unsigned char row = ::drop((unsigned char)button, (unsigned char)piece(p));
+        return row == NO_ROW ? -1 : row;
+    }
+    void undo(unsigned col) override { ::undo((unsigned char)col); }
+    bool wins(c4::Player p) override { return check_win((unsigned char)piece(p)); }
+    bool draw() override { return ::draw(); }
+};
+
+template <unsigned W, unsigned H>
+struct Template final : Engine {
+    const char* name() const override { return "rules.hpp"; }
+    void reset() override { board = {}; }
+    int drop(unsigned button, c4::Player p) override { return board.drop(button, p); }
+    void undo(unsigned col) override { board.undo(col); }
+    bool wins(c4::Player p) override { return board.wins(p); }
+    bool draw() override { return board.full(); }
+
+    c4::Board<W, H> board;
+};
+
+// The engines for one board size, the reference first.
+template <class G>
+std::vector<std::unique_ptr<Engine>> engines_for(unsigned geom)
+{
+    std::vector<std::unique_ptr<Engine>> list;
+    if (G::width <= 7 && G::height == G::width - 1)
+        list.push_back(std::make_unique<Legacy>(G::width));
+    list.push_back(std::make_unique<Firmware>(geom));
+    list.push_back(std::make_unique<Template<G::width, G::height>>());
+    return list;
+}
+
+class Differential {
+public:
+    explicit Differential(std::vector<std::unique_ptr<Engine>> engines) : engines_(std::move(engines)) {}
+
+    // Checks every press at exactly `depth` moves into every game. Returns
+    // false, with the mismatch in report(), if the engines disagree.
+    bool check(unsigned depth)
+    {
+        for (auto& e : engines_)
+            e->reset();
+        threat_clear();
+        moves_.clear();
+        checked_ = 0;
+        return walk(depth, c4::X);
+    }
+
+    unsigned long long checked() const { return checked_; }
+    const std::string& report() const { return report_; }
+
+private:
+    bool walk(unsigned depth, c4::Player p)
+    {
+        for (unsigned b = 0; b < BUTTONS; b++) {
+            if (depth == 1) {
+                if (!compare_press(b, p))
+                    return false;
+                continue;
+            }
+
+            int row = engines_[0]->drop(b, p);
+            if (row < 0)
+                continue;
+            for (std::size_t i = 1; i < engines_.size(); i++)
+                engines_[i]->drop(b, p);
+            moves_.push_back(b);
+
+            // the game carries on only if nobody won and it is no draw
+            Threats saved;
+            bool won = engines_[0]->wins(p);
+            if (!won && !follow_threats(b, p, saved))
+                return false;
+            if (!won && !engines_[0]->draw() && !walk(depth - 1, c4::other(p)))
+                return false;
+
+            moves_.pop_back();
+            if (!won)
+                saved.restore();
+            for (auto& e : engines_)
+                e->undo(b);
+        }
+        return true;
+    }
+
+    // threat.c's state, which has no undo of its own.
+    struct Threats {
+        unsigned char x[MAX_WIDTH];
+        unsigned char o[MAX_WIDTH];
+        unsigned int tx, to;
+
+        void save()
+        {
+            std::memcpy(x, mask_x, sizeof x);
+            std::memcpy(o, mask_o, sizeof o);
+            tx = threat_x;
+            to = threat_o;
+        }
+        void restore()
+        {
+            std::memcpy(mask_x, x, sizeof x);
+            std::memcpy(mask_o, o, sizeof o);
+            threat_x = tx;
+            threat_o = to;
+        }
+    };
+
+    // Columns where a piece of player wins at once, by trying each one on
+    // the firmware board.
+    static unsigned rescan(unsigned char player)
+    {
+        unsigned cols = 0;
+        for (unsigned char c = 0; c < width; c++) {
+            if (::drop(c, player) == NO_ROW)
+                continue;
+            if (check_win(player))
+                cols |= 1u << c;
+            ::undo(c);
+        }
+        return cols;
+    }
+
+    // Feeds the move just made (b, not a win) to threat.c, saving its
+    // state first, and compares the answer with a rescan.
+    bool follow_threats(unsigned b, c4::Player p, Threats& saved)
+    {
+        saved.save();
+        threat_update((unsigned char)b, (unsigned char)piece(p));
+        unsigned want_x = rescan(SPACE_X);
+        unsigned want_o = rescan(SPACE_O);
+        if (threat_x == want_x && threat_o == want_o)
+            return true;
+
+        char buf[96];
+        std::snprintf(buf, sizeof buf, ", threats: threat.c X=%03x O=%03x, rescan X=%03x O=%03x", threat_x, threat_o, want_x, want_o);
+        report_ = "moves";
+        for (unsigned m : moves_)
+            report_ += " " + std::to_string(m);
+        report_ += buf;
+        return false;
+    }
+
+    bool compare_press(unsigned b, c4::Player p)
+    {
+        checked_++;
+        std::vector<int> rows;
+        for (auto& e : engines_)
+            rows.push_back(e->drop(b, p));
+
+        bool same = true;
+        for (int r : rows)
+            same = same && r == rows[0];
+        if (!same) {
+            mismatch(b, "row", rows);
+            return false;
+        }
+        if (rows[0] < 0)
+            return true;
+
+        const char* what[] = { "check_win(X)", "check_win(O)", "draw()" };
+        for (int k = 0; k < 3; k++) {
+            std::vector<int> answers;
+            for (auto& e : engines_)
+                answers.push_back(k == 2 ? e->draw() : e->wins(k == 0 ? c4::X : c4::O));
+            for (int a : answers)
+                same = same && a == answers[0];
+            if (!same) {
+                mismatch(b, what[k], answers);
+                return false;
+            }
+        }
+
+        if (!engines_[0]->wins(p)) {
+            Threats saved;
+            moves_.push_back(b);
+            if (!follow_threats(b, p, saved))
+                return false;
+            moves_.pop_back();
+            saved.restore();
+        }
+
+        for (auto& e : engines_)
+            e->undo(b);
+        return true;
+    }
+
+    void mismatch(unsigned b, const char* what, const std::vector<int>& answers)
+    {
+        report_ = "moves";
+        for (unsigned m : moves_)
+            report_ += " " + std::to_string(m);
+        report_ += " " + std::to_string(b) + ", " + what + ":";
+        for (std::size_t i = 0; i < engines_.size(); i++)
+            report_ += std::string(" ") + engines_[i]->name() + "=" + std::to_string(answers[i]);
+    }
+
+    std::vector<std::unique_ptr<Engine>> engines_;
+    std::vector<unsigned> moves_;
+    unsigned long long checked_ = 0;
+    std::string report_;
+};
+
+// Every game up to depth moves, with the checks the game loop makes after
+// each move. Returns the number of moves played, so nothing is optimised
+// away.
+template <class E>
+unsigned long long walk_tree(E& e, unsigned depth, c4::Player p)
+{
+    unsigned long long n = 0;
+    for (unsigned b = 0; b < BUTTONS; b++) {
+        if (e.drop(b, p) < 0)
+            continue;
+        n++;
+        if (depth > 1 && !e.wins(p) && !e.draw())
+            n += walk_tree(e, depth - 1, c4::other(p));
+        e.undo(b);
+    }
+    return n;
+}
+
+template <class E>
+void time_engine(E& e, unsigned depth, double& legacy_ns)
+{
+    e.reset();
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long moves = walk_tree(e, depth, c4::X);
+    std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+    double ns = moves ? took.count() / double(moves) : 0.0;
+
+    std::printf("    %-10s %12llu moves %8.1f ns/move", e.name(), moves, ns);
+    if (std::is_same<E, Legacy>::value)
+        legacy_ns = ns;
+    else if (legacy_ns > 0)
+        std::printf("  %5.1fx legacy", legacy_ns / ns);
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned depth = 6;
+    unsigned only_w = 0;
+    unsigned only_h = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+            depth = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-g") && i + 1 < argc && std::sscanf(argv[++i], "%ux%u", &only_w, &only_h) == 2)
+            ;
+        else {
+            std::fprintf(stderr, "usage: harness [-d depth] [-g WxH]\n");
+            return 2;
+        }
+    }
+
+    int status = 0;
+    unsigned geom = 0;
+    c4::for_each_geometry([&](auto g) {
+        using G = decltype(g);
+        unsigned index = geom++;
+        if (status || (only_w && (G::width != only_w || G::height != only_h)))
+            return;
+
+        Differential diff(engines_for<G>(index));
+        std::printf("%ux%u\n", G::width, G::height);
+        for (unsigned d = 1; d <= depth; d++) {
+            bool ok = diff.check(d);
+            std::printf("    depth %2u: %12llu presses %s\n", d, diff.checked(), ok ? "agree" : "MISMATCH");
+            if (!ok) {
+                std::printf("    %s\n", diff.report().c_str());
+                status = 1;
+                return;
+            }
+        }
+
+        double legacy_ns = 0;
+        if (G::width <= 7 && G::height == G::width - 1) {
+            Legacy e(G::width);
+            time_engine(e, depth, legacy_ns);
+        }
+        Firmware f(index);
+        time_engine(f, depth, legacy_ns);
+        Template<G::width, G::height> t;
+        time_engine(t, depth, legacy_ns);
+    });
+
+    return status;
+}
@@ -0,0 +1,368 @@
+// latency - per-stage latency report from the board's flight recorder.
+//
+// The firmware notes each stage of a move in a ring of timestamped events
+// (src/trace.h) and dumps it when sent a 'T', as "t ..." text lines or as
+// MSG_TRACE frames depending on the output mode. This reads dumps, from
+// captured files or by asking the board itself, pairs up the events of
+// each move and prints, for every stage, the percentiles and a histogram
+// of how long it took:
+//
+//     press to move     button press debounced until the game dropped the piece
+//     remote to move    move from the other board until it was dropped
+//     win check         piece dropped until the game knew whether it won,
+//                       split by whether ponder.c already had the answer
+//     output wait       win check done until the render task started the move
+//     output <job>      render job started until its last byte went to the UART
+//     press to board    the whole way, press until the board was out
+//     song              a tune, start to end
+//
+// Each dump empties the ring on the board, so dumps taken one after the
+// other never repeat an event; a stage that straddles two dumps is lost.
+//
+// Build: g++ -std=c++17 -O2 -o latency host/latency.cpp
+// Usage: latency [file...]                              (stdin if none)
+//        latency -d device [-b baud] [-n dumps] [-i seconds]
+//        (default 9600 baud, 1 dump, 10 seconds apart)
+
+#include "firmware.hpp"
+#include "protocol.hpp"
+#include "serial.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// One timer step of tick_fine() in microseconds; a millisecond is the
+// 65536 - TICK_RELOAD counts of timer 0.
+const double fine_step_us = TICK_FINE_STEP * 1000.0 / double(65536ul - TICK_RELOAD);
+
+struct Event {
+    double us = 0; // since the first event of its dump
+    unsigned type = 0;
+    unsigned arg = 0;
+};
+
+const char* job_name(unsigned job)
+{
+    switch (job) {
+    case 1: return "select";
+    case 2: return "new game";
+    case 3: return "move";
+    case 4: return "result";
+    case 5: return "link";
+    case 6: return "trace";
+    case 7: return "session";
+    case 8: return "uart test";
+    default: return "?";
+    }
+}
+const unsigned JOB_MOVE = 3;
+
+// Collects dumps out of the board's stream, text or binary.
+class DumpReader {
+public:
+    std::vector<std::vector<Event>> dumps; // the ones with events
+    std::size_t completed = 0;             // every dump ended, empty or not
+
+    DumpReader()
+    {
+        parser_.on_text = [this](std::uint8_t c) { text(c); };
+        parser_.on_frame = [this](const c4::Frame& f) {
+            if (f.type != MSG_TRACE)
+                return;
+            if (f.length == 0)
+                end();
+            for (unsigned i = 0; i + TRACE_ENTRY <= f.length; i += TRACE_ENTRY)
+                entry(f.payload + i);
+        };
+    }
+
+    void feed(const std::uint8_t* data, std::size_t n) { parser_.feed(data, n); }
+
+private:
+    // "t 1A2B 3F 51" is an entry, "t" alone ends the dump
+    void text(std::uint8_t c)
+    {
+        if (c != '\n' && c != '\r') {
+            if (line_.size() < 64)
+                line_.push_back(char(c));
+            return;
+        }
+        if (line_ == "t") {
+            end();
+        } else if (line_.size() == 12 && line_[0] == 't') {
+            unsigned ms, fine, ev;
+            if (std::sscanf(line_.c_str(), "t %4x %2x %2x", &ms, &fine, &ev) == 3) {
+                std::uint8_t e[TRACE_ENTRY] = { std::uint8_t(ms >> 8), std::uint8_t(ms), std::uint8_t(fine), std::uint8_t(ev) };
+                entry(e);
+            }
+        }
+        line_.clear();
+    }
+
+    // The millisecond count wraps every 65.536 s; entries are in order, so
+    // a step backwards is a wrap.
+    void entry(const std::uint8_t* e)
+    {
+        unsigned ms = unsigned(e[0]) << 8 | e[1];
+        if (!current_.empty() && ms < last_ms_)
+            wraps_++;
+        last_ms_ = ms;
+
+        Event ev;
+        ev.us = (double(wraps_) * 65536.0 + ms) * 1000.0 + e[2] * fine_step_us;
+        ev.type = e[3] >> 4;
+        ev.arg = e[3] & 0x0F;
+        current_.push_back(ev);
+    }
+
+    void end()
+    {
+        if (!current_.empty())
+            dumps.push_back(std::move(current_));
+        current_.clear();
+        completed++;
+        wraps_ = 0;
+    }
+
+    c4::FrameParser parser_;
+    std::string line_;
+    std::vector<Event> current_;
+    unsigned last_ms_ = 0;
+    unsigned long wraps_ = 0;
+};
+
+using Stages = std::map<std::string, std::vector<double>>;
+
+// Walks a dump the way a move goes through the firmware.
+void pair_up(const std::vector<Event>& dump, Stages& stages)
+{
+    double press = -1, taken = -1, checked = -1, song = -1;
+    bool remote = false;
+    // the press of the last move the board drawing now includes; moves
+    // made while it is drawn wait for the next one
+    double drawn_press = -1;
+    bool drawn_remote = false;
+    double render[16];
+    std::fill(render, render + 16, -1.0);
+
+    for (const Event& e : dump) {
+        switch (e.type) {
+        case TRACE_PRESS:
+        case TRACE_REMOTE:
+            // the game takes the latest press, earlier ones were refused
+            press = e.us;
+            remote = e.type == TRACE_REMOTE;
+            break;
+        case TRACE_TAKEN:
+            if (press >= 0)
+                stages[remote ? "remote to move" : "press to move"].push_back(e.us - press);
+            taken = e.us;
+            break;
+        case TRACE_CHECKED:
+            if (taken >= 0)
+                stages[e.arg & 2 ? "win check, pondered" : "win check, check_win"].push_back(e.us - taken);
+            checked = e.us;
+            taken = -1;
+            break;
+        case TRACE_RENDER:
+            if (e.arg == JOB_MOVE && checked >= 0)
+                stages["output wait"].push_back(e.us - checked);
+            if (e.arg == JOB_MOVE) {
+                drawn_press = press;
+                drawn_remote = remote;
+                press = -1;
+            }
+            checked = -1;
+            render[e.arg] = e.us;
+            break;
+        case TRACE_SHOWN:
+            if (render[e.arg] >= 0)
+                stages[std::string("output ") + job_name(e.arg)].push_back(e.us - render[e.arg]);
+            render[e.arg] = -1;
+            if (e.arg == JOB_MOVE && drawn_press >= 0)
+                stages[drawn_remote ? "remote to board" : "press to board"].push_back(e.us - drawn_press);
+            if (e.arg == JOB_MOVE)
+                drawn_press = -1;
+            break;
+        case TRACE_SONG:
+            song = e.us;
+            break;
+        case TRACE_QUIET:
+            if (song >= 0)
+                stages["song"].push_back(e.us - song);
+            song = -1;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    std::size_t i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// Powers of two in microseconds, one bar each.
+void histogram(const std::vector<double>& sorted)
+{
+    std::map<int, std::size_t> buckets;
+    for (double us : sorted)
+        buckets[us < 1 ? 0 : int(std::log2(us)) + 1]++;
+    std::size_t most = 0;
+    for (auto& b : buckets)
+        most = std::max(most, b.second);
+
+    for (int b = buckets.begin()->first; b <= buckets.rbegin()->first; b++) {
+        std::size_t n = buckets.count(b) ? buckets[b] : 0;
+        double lo = b ? std::ldexp(1.0, b - 1) : 0;
+        double hi = std::ldexp(1.0, b);
+        int bar = int((n * 40 + most - 1) / most);
+        std::printf("  %8.3f - %8.3f ms |%-40s %zu\n", lo / 1000, hi / 1000, std::string(std::size_t(bar), '#').c_str(), n);
+    }
+}
+
+void report(Stages& stages, std::size_t dumps, std::size_t events)
+{
+    std::printf("%zu dumps, %zu events\n", dumps, events);
+    for (auto& s : stages) {
+        std::vector<double>& v = s.second;
+        std::sort(v.begin(), v.end());
+        std::printf("\n%s: %zu, ms min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", s.first.c_str(), v.size(), v.front() / 1000,
+            percentile(v, 50) / 1000, percentile(v, 90) / 1000, percentile(v, 99) / 1000, v.back() / 1000);
+        histogram(v);
+    }
+}
+
+bool read_all(int fd, DumpReader& reader)
+{
+    std::uint8_t buf[4096];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof buf);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+        if (n == 0)
+            return true;
+        reader.feed(buf, std::size_t(n));
+    }
+}
+
+// Asks the board for a dump and reads until it has ended, or the board
+// has been quiet for two seconds. An idle board ends an empty one.
+bool ask(int fd, DumpReader& reader)
+{
+    std::size_t had = reader.completed;
+    const char command = 'T';
+    if (write(fd, &command, 1) != 1)
+        return false;
+
+    std::uint8_t buf[256];
+    while (reader.completed == had) {
+        pollfd p = { fd, POLLIN, 0 };
+        int r = poll(&p, 1, 2000);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        ssize_t n = read(fd, buf, sizeof buf);
+        if (n <= 0)
+            return false;
+        reader.feed(buf, std::size_t(n));
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long baud = 9600;
+    const char* device = nullptr;
+    int count = 1;
+    int interval = 10;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            baud = std::strtol(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+            device = argv[++i];
+        else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            count = int(std::strtol(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-i") && i + 1 < argc)
+            interval = int(std::strtol(argv[++i], nullptr, 10));
+        else if (argv[i][0] == '-' && argv[i][1]) {
+            std::fprintf(stderr, "usage: latency [file...]\n       latency -d device [-b baud] [-n dumps] [-i seconds]\n");
+            return 2;
+        } else
+            files.push_back(argv[i]);
+    }
+
+    DumpReader reader;
+    if (device) {
+        if (!c4::to_speed(baud)) {
+            std::fprintf(stderr, "latency: unsupported baud rate %ld\n", baud);
+            return 2;
+        }
+        int fd = c4::open_serial(device, baud, O_RDWR);
+        if (fd < 0) {
+            std::fprintf(stderr, "latency: %s: %s\n", device, std::strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (i)
+                sleep(unsigned(interval));
+            std::size_t had = reader.dumps.size();
+            if (!ask(fd, reader)) {
+                std::fprintf(stderr, "latency: %s: no dump came back\n", device);
+                return 1;
+            }
+            std::size_t n = reader.dumps.size() > had ? reader.dumps.back().size() : 0;
+            std::fprintf(stderr, "latency: dump %d of %d, %zu events\n", i + 1, count, n);
+        }
+        close(fd);
+    } else if (files.empty()) {
+        read_all(STDIN_FILENO, reader);
+    } else {
+        for (const char* path : files) {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0 || !read_all(fd, reader)) {
+                std::fprintf(stderr, "latency: %s: %s\n", path, std::strerror(errno));
+                return 1;
+            }
+            close(fd);
+        }
+    }
+
+    Stages stages;
+    std::size_t events = 0;
+    for (const auto& dump : reader.dumps) {
+        pair_up(dump, stages);
+        events += dump.size();
+    }
+    if (stages.empty()) {
+        std::fprintf(stderr, "latency: no complete stages in %zu dumps\n", reader.completed);
+        return 1;
+    }
+    report(stages, reader.completed, events);
+    return 0;
+}
@@ -0,0 +1,429 @@
+// linksim - two boards playing over the I2C link, on the host.
+//
+// Forks two processes that each run the firmware's link layer and rules
+// (src/link.c, src/proto.c, src/rules.c, compiled in below) against a
+// software I2C bus: a SOCK_SEQPACKET socket pair, one message per packet.
+// The bus loses and corrupts messages at the given rates, takes as long as
+// a 100 kHz transfer would, and refuses messages while the receiver still
+// holds one, as the real slave does by not acknowledging. At the -h rate a
+// transfer hangs and is never delivered, until the link aborts it.
+//
+// Board A picks a random size and plays X, board B plays O, both pick
+// random columns. Every game is started with a sync from A, as pressing a
+// button on A does. The parent collects when each move was sent and when
+// the other side's game took it in, then reports the propagation latency,
+// resends and whether both boards finished every game on the same board.
+//
+// Build: g++ -std=c++17 -O2 -o linksim host/linksim.cpp
+// Usage: linksim [-n games] [-l loss%] [-c corrupt%] [-h hang%] [-s seed]
+//
+// Exits with 1 when the boards disagree, a move went missing or the link
+// gave up.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// The firmware sources themselves. The memory class macros from
+// src/compiler.h would break any C++ header included after them, so the
+// standard headers come first.
+#define LINK_ENABLE 1
+
+extern "C" {
+#include "../src/compiler.h"
+#include "../src/i2c.h"
+#include "../src/tick.h"
+#include "../src/proto.c"
+#include "../src/rules.c"
+#include "../src/link.c"
+}
+
+#undef code
+#undef data
+#undef idata
+#undef xdata
+
+namespace {
+
+std::uint64_t now_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::uint64_t(ts.tv_sec) * 1000000u + std::uint64_t(ts.tv_nsec) / 1000u;
+}
+
+// A 5 byte message is address plus 5 bytes, 9 clocks each, at 100 kHz.
+constexpr std::uint64_t transfer_us(unsigned bytes) { return (bytes + 1) * 9 * 10; }
+
+// One end of the software bus.
+struct Bus {
+    int fd = -1;
+    int loss = 0; // percent
+    int corrupt = 0; // percent
+    int hang = 0; // percent
+    std::mt19937 rng;
+    std::uint64_t start = 0;
+    unsigned char state = I2C_IDLE;
+    std::uint64_t busy_until = 0;
+    unsigned char rx_len = 0;
+    // Packet on the wire: when it has finished arriving, then the bytes.
+    struct Packet {
+        std::uint64_t at;
+        unsigned char len;
+        unsigned char bytes[I2C_MAX_MSG];
+    };
+    std::vector<Packet> incoming;
+};
+
+Bus bus;
+
+int percent(std::mt19937& rng) { return int(rng() % 100); }
+
+} // namespace
+
+// The i2c.h and tick.h functions the link layer calls, on the software bus.
+extern "C" {
+
+unsigned char i2c_rx[I2C_MAX_MSG];
+
+void i2c_init() {}
+
+unsigned char i2c_send(unsigned char* msg, unsigned char length)
+{
+    if (i2c_status() == I2C_BUSY)
+        return 0;
+
+    std::uint64_t t = now_us();
+    bus.busy_until = t + transfer_us(length);
+    if (percent(bus.rng) < bus.hang) {
+        // busy until i2c_abort()
+        bus.busy_until = UINT64_MAX;
+        bus.state = I2C_BUSY;
+        return 1;
+    }
+    if (percent(bus.rng) < bus.loss) {
+        // nobody acknowledged the address
+        bus.state = I2C_FAILED;
+        return 1;
+    }
+
+    Bus::Packet p;
+    p.at = bus.busy_until;
+    p.len = length;
+    std::memcpy(p.bytes, msg, length);
+    if (percent(bus.rng) < bus.corrupt)
+        p.bytes[bus.rng() % length] ^= std::uint8_t(1u << (bus.rng() % 8));
+    // busy until the transfer time has passed, see i2c_status()
+    bus.state = send(bus.fd, &p, sizeof p, 0) < 0 ? I2C_FAILED : I2C_BUSY;
+    return 1;
+}
+
+unsigned char i2c_status()
+{
+    if (bus.state == I2C_BUSY && now_us() >= bus.busy_until)
+        bus.state = I2C_DONE;
+    return bus.state;
+}
+
+unsigned char i2c_received()
+{
+    Bus::Packet p;
+    while (recv(bus.fd, &p, sizeof p, MSG_DONTWAIT) == ssize_t(sizeof p))
+        bus.incoming.push_back(p);
+
+    while (!bus.rx_len && !bus.incoming.empty() && now_us() >= bus.incoming.front().at) {
+        const Bus::Packet& first = bus.incoming.front();
+        std::memcpy(i2c_rx, first.bytes, first.len);
+        bus.rx_len = first.len;
+        bus.incoming.erase(bus.incoming.begin());
+    }
+    // while one is held, others that finish arriving are not acknowledged
+    if (bus.rx_len) {
+        std::uint64_t t = now_us();
+        bus.incoming.erase(std::remove_if(bus.incoming.begin(), bus.incoming.end(),
+                               [t](const Bus::Packet& q) { return q.at <= t; }),
+            bus.incoming.end());
+    }
+    return bus.rx_len;
+}
+
+void i2c_release() { bus.rx_len = 0; }
+
+void i2c_abort() { bus.state = I2C_FAILED; }
+
+void tick_init() {}
+
+unsigned int tick_now() { return (unsigned int)((now_us() - bus.start) / 1000u); }
+
+unsigned int tick_since(unsigned int start) { return tick_now() - start; }
+
+} // extern "C"
+
+namespace {
+
+std::uint32_t board_hash()
+{
+    std::uint32_t h = 2166136261u;
+    auto mix = [&](unsigned char b) { h = (h ^ b) * 16777619u; };
+    mix(width);
+    mix(height);
+    for (int i = 0; i < MAX_WIDTH; i++) {
+        mix(cols_x[i]);
+        mix(cols_o[i]);
+    }
+    return h;
+}
+
+// Report lines, one write each so the two boards' lines do not mix:
+//   S <game> <ply> <us>          move sent (queued on the link)
+//   D <game> <ply> <us>          move taken in by the other board
+//   H <board> <game> <hash>      board at the end of a game
+//   R <board> <resends> <rtt max ms> <failed>
+void report(int fd, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+void report(int fd, const char* fmt, ...)
+{
+    char line[128];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = std::vsnprintf(line, sizeof line, fmt, ap);
+    va_end(ap);
+    ssize_t written = write(fd, line, std::size_t(n));
+    (void)written;
+}
+
+// One pass of the board's main loop. Sleeps a little so the two boards
+// share a CPU without leaving each other's messages unread for a whole
+// time slice, which the bus would count as refused.
+void step()
+{
+    link_task();
+    timespec ts = { 0, 50000 };
+    nanosleep(&ts, nullptr);
+}
+
+// One board. Returns the exit status.
+int run_board(char name, int games, int out)
+{
+    const unsigned char mine = name == 'A' ? SPACE_X : SPACE_O;
+    std::mt19937 rng(bus.rng());
+    bool failed = false;
+
+    link_init();
+    for (int game = 0; game < games && !failed; game++) {
+        // start the game
+        if (name == 'A') {
+            unsigned char g = (unsigned char)(rng() % GEOM_COUNT);
+            while (!link_send(LINK_SYNC, g, SPACE_X))
+                step();
+            rules_select(g);
+        } else {
+            while (link_peek() != LINK_SYNC)
+                step();
+            rules_select(link_a);
+            link_take();
+        }
+        board_construct();
+
+        unsigned char player = SPACE_X;
+        for (int ply = 0;; ply++) {
+            unsigned char col;
+            if (player == mine) {
+                do
+                    col = (unsigned char)(rng() % width);
+                while (heights[col] >= height);
+                while (!link_send(LINK_MOVE, col, 0) && !link_failed())
+                    step();
+                report(out, "S %d %d %llu\n", game, ply, (unsigned long long)now_us());
+            } else {
+                while (link_peek() != LINK_MOVE && !link_failed())
+                    step();
+                if (link_failed())
+                    break;
+                report(out, "D %d %d %llu\n", game, ply, (unsigned long long)now_us());
+                col = link_a;
+                link_take();
+            }
+            if (link_failed())
+                break;
+
+            drop(col, player);
+            if (check_win(player) || draw())
+                break;
+            player = player == SPACE_X ? SPACE_O : SPACE_X;
+        }
+
+        failed = link_failed();
+        report(out, "H %c %d %08x\n", name, game, board_hash());
+    }
+
+    // keep answering until the other board has its acknowledgements
+    std::uint64_t end = now_us() + 300000u;
+    while (now_us() < end)
+        step();
+
+    report(out, "R %c %u %u %d\n", name, link_resends, link_rtt_max, failed ? 1 : 0);
+    return failed ? 1 : 0;
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    std::size_t i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int games = 100;
+    int loss = 5;
+    int corrupt = 2;
+    int hang = 0;
+    unsigned seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        long v = std::strtol(argv[i + 1], nullptr, 10);
+        if (!std::strcmp(argv[i], "-n"))
+            games = int(v);
+        else if (!std::strcmp(argv[i], "-l"))
+            loss = int(v);
+        else if (!std::strcmp(argv[i], "-c"))
+            corrupt = int(v);
+        else if (!std::strcmp(argv[i], "-h"))
+            hang = int(v);
+        else if (!std::strcmp(argv[i], "-s"))
+            seed = unsigned(v);
+        else {
+            std::fprintf(stderr, "usage: linksim [-n games] [-l loss%%] [-c corrupt%%] [-h hang%%] [-s seed]\n");
+            return 2;
+        }
+    }
+
+    int wire[2];
+    int pipefd[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, wire) < 0 || pipe(pipefd) < 0) {
+        std::perror("linksim");
+        return 1;
+    }
+
+    std::uint64_t start = now_us();
+    pid_t pids[2];
+    for (int b = 0; b < 2; b++) {
+        pids[b] = fork();
+        if (pids[b] < 0) {
+            std::perror("linksim: fork");
+            return 1;
+        }
+        if (pids[b] == 0) {
+            close(pipefd[0]);
+            close(wire[1 - b]);
+            bus.fd = wire[b];
+            bus.loss = loss;
+            bus.corrupt = corrupt;
+            bus.hang = hang;
+            bus.rng.seed(seed * 2 + unsigned(b));
+            bus.start = start;
+            _exit(run_board(b == 0 ? 'A' : 'B', games, pipefd[1]));
+        }
+    }
+    close(pipefd[1]);
+    close(wire[0]);
+    close(wire[1]);
+
+    // Read everything the boards report.
+    std::string text;
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(pipefd[0], buf, sizeof buf);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        text.append(buf, std::size_t(n));
+    }
+
+    int status = 0;
+    for (pid_t pid : pids) {
+        int st = 0;
+        waitpid(pid, &st, 0);
+        if (!WIFEXITED(st) || WEXITSTATUS(st))
+            status = 1;
+    }
+
+    std::map<std::pair<int, int>, std::uint64_t> sent;
+    std::map<std::pair<int, int>, std::uint64_t> delivered;
+    std::map<int, std::string> hash[2];
+    unsigned resends = 0;
+    unsigned rtt_max = 0;
+
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t eol = text.find('\n', pos);
+        std::string line = text.substr(pos, eol - pos);
+        pos = eol == std::string::npos ? text.size() : eol + 1;
+
+        int game, ply, failed;
+        unsigned long long us;
+        char board;
+        char h[16];
+        unsigned r, m;
+        if (std::sscanf(line.c_str(), "S %d %d %llu", &game, &ply, &us) == 3)
+            sent[{ game, ply }] = us;
+        else if (std::sscanf(line.c_str(), "D %d %d %llu", &game, &ply, &us) == 3)
+            delivered[{ game, ply }] = us;
+        else if (std::sscanf(line.c_str(), "H %c %d %15s", &board, &game, h) == 3)
+            hash[board == 'B'][game] = h;
+        else if (std::sscanf(line.c_str(), "R %c %u %u %d", &board, &r, &m, &failed) == 4) {
+            resends += r;
+            rtt_max = std::max(rtt_max, m);
+        }
+    }
+
+    std::vector<double> latency;
+    std::size_t missing = 0;
+    for (const auto& s : sent) {
+        auto d = delivered.find(s.first);
+        if (d == delivered.end())
+            missing++;
+        else
+            latency.push_back(double(d->second - s.second) / 1000.0);
+    }
+    std::sort(latency.begin(), latency.end());
+
+    int mismatched = 0;
+    for (int g = 0; g < games; g++)
+        if (!hash[0].count(g) || hash[0][g] != hash[1][g])
+            mismatched++;
+
+    double mean = 0;
+    for (double l : latency)
+        mean += l;
+    if (!latency.empty())
+        mean /= double(latency.size());
+
+    std::printf("games %d, moves %zu, loss %d%%, corrupt %d%%, hang %d%%\n", games, sent.size(), loss, corrupt, hang);
+    std::printf("move latency ms: min %.2f mean %.2f p50 %.2f p99 %.2f max %.2f\n",
+        latency.empty() ? 0.0 : latency.front(), mean, percentile(latency, 50), percentile(latency, 99),
+        latency.empty() ? 0.0 : latency.back());
+    std::printf("resends %u, worst acknowledgement %u ms\n", resends, rtt_max);
+    std::printf("moves not delivered %zu, games that ended differently %d\n", missing, mismatched);
+
+    if (missing || mismatched)
+        status = 1;
+    return status;
+}
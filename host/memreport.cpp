@@ -0,0 +1,316 @@
+// memreport - RAM/ROM budget report for the firmware.
+//
+// Reads the map file the Keil BL51 linker writes (project-three.m51) and
+// lists every segment and every RAM symbol with its size, largest first,
+// then checks the totals against the budgets. Exits with 1 when a budget
+// is exceeded, so running it after the build (project-three.Uv2 does)
+// fails the build.
+//
+// Symbol sizes are not in the map file; they are taken as the distance to
+// the next symbol in the same segment, which is exact for the compiler's
+// own variables.
+//
+// Besides the totals it checks where internal RAM ends up: the register
+// banks, bit area and data segments must end within the directly
+// addressed 128 bytes (--direct), and the stack, which BL51 puts above
+// everything else, needs room to the top of the 256 (--stack).
+//
+// Build: g++ -std=c++17 -O2 -o memreport host/memreport.cpp
+// Usage: memreport [--data N] [--xdata N] [--code N] [--direct N] [--stack N]
+//                  [-o report.txt] project-three.m51
+//
+// Default budgets are the P89LPC932A1 less headroom: 224 of the 256 bytes
+// of internal RAM (the rest is stack), all 128 bytes of direct RAM, at
+// least 32 bytes of stack, 512 bytes of XRAM, 8 KB of flash.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Segment {
+    std::string type; // REG, DATA, BIT, IDATA, XDATA, CODE
+    unsigned long base = 0;
+    unsigned long base_bit = 0; // BIT segments start at base.base_bit
+    unsigned long length = 0; // bytes, bits for BIT
+    std::string name;
+};
+
+struct Symbol {
+    char space = 0; // C, D, I, X, B
+    unsigned long address = 0;
+    std::string name;
+    std::string module;
+    unsigned long size = 0;
+    std::string segment;
+};
+
+struct Totals {
+    double data = -1; // as "Program Size: data=52.1" reports it, bytes.bits
+    long xdata = -1;
+    long code = -1;
+};
+
+// "data" for D: and I: (both are internal RAM), "xdata", "code".
+std::string space_name(char s)
+{
+    switch (s) {
+    case 'D':
+    case 'I':
+    case 'B': return "data";
+    case 'X': return "xdata";
+    default: return "code";
+    }
+}
+
+std::string segment_space(const std::string& type)
+{
+    if (type == "XDATA")
+        return "xdata";
+    if (type == "CODE")
+        return "code";
+    return "data";
+}
+
+bool parse_map(std::istream& in, std::vector<Segment>& segments, std::vector<Symbol>& symbols, Totals& totals)
+{
+    static const std::regex seg_re(R"(^\s+(REG|DATA|BIT|IDATA|XDATA|CODE)\s+([0-9A-F]+)H(?:\.([0-7]))?\s+([0-9A-F]+)H(?:\.([0-7]))?\s+\w+\s*(.*?)\s*$)");
+    static const std::regex sym_re(R"(^\s+([CDIXB]):([0-9A-F]+)H(?:\.[0-7])?\s+(PUBLIC|SYMBOL)\s+(\S+)\s*$)");
+    static const std::regex mod_re(R"(^\s+-------\s+MODULE\s+(\S+))");
+    static const std::regex size_re(R"(Program Size:\s+data=([0-9.]+)\s+xdata=(\d+)\s+code=(\d+))");
+
+    std::string line;
+    std::string module;
+    bool any = false;
+    std::smatch m;
+
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (std::regex_search(line, m, size_re)) {
+            totals.data = std::atof(m[1].str().c_str());
+            totals.xdata = std::atol(m[2].str().c_str());
+            totals.code = std::atol(m[3].str().c_str());
+            any = true;
+        } else if (std::regex_match(line, m, seg_re)) {
+            Segment s;
+            s.type = m[1];
+            s.base = std::strtoul(m[2].str().c_str(), nullptr, 16);
+            s.length = std::strtoul(m[4].str().c_str(), nullptr, 16);
+            if (s.type == "BIT") {
+                s.base_bit = std::strtoul(m[3].str().c_str(), nullptr, 10);
+                s.length = s.length * 8 + std::strtoul(m[5].str().c_str(), nullptr, 10);
+            }
+            s.name = m[6];
+            segments.push_back(s);
+            any = true;
+        } else if (std::regex_search(line, m, mod_re)) {
+            module = m[1];
+        } else if (std::regex_match(line, m, sym_re)) {
+            Symbol s;
+            s.space = m[1].str()[0];
+            s.address = std::strtoul(m[2].str().c_str(), nullptr, 16);
+            s.name = m[4];
+            s.module = module;
+            // D:0080H and up are special function registers, not RAM.
+            if ((s.space == 'D' || s.space == 'B') && s.address >= 0x80)
+                continue;
+            symbols.push_back(s);
+        }
+    }
+    return any;
+}
+
+// Gives every RAM symbol the segment it sits in and a size up to the next
+// symbol (or the end of the segment).
+void size_symbols(const std::vector<Segment>& segments, std::vector<Symbol>& symbols)
+{
+    std::vector<Symbol> ram;
+    for (const auto& s : symbols)
+        if (s.space == 'D' || s.space == 'I' || s.space == 'X')
+            ram.push_back(s);
+
+    // the same variable is listed once per module that mentions it
+    std::sort(ram.begin(), ram.end(), [](const Symbol& a, const Symbol& b) {
+        return space_name(a.space) != space_name(b.space) ? space_name(a.space) < space_name(b.space) : a.address < b.address;
+    });
+    ram.erase(std::unique(ram.begin(), ram.end(), [](const Symbol& a, const Symbol& b) {
+        return space_name(a.space) == space_name(b.space) && a.address == b.address;
+    }), ram.end());
+
+    for (std::size_t i = 0; i < ram.size(); i++) {
+        Symbol& s = ram[i];
+        for (const auto& seg : segments) {
+            if (seg.type == "BIT" || seg.type == "CODE" || segment_space(seg.type) != space_name(s.space))
+                continue;
+            if (s.address >= seg.base && s.address < seg.base + seg.length) {
+                unsigned long end = seg.base + seg.length;
+                if (i + 1 < ram.size() && space_name(ram[i + 1].space) == space_name(s.space))
+                    end = std::min(end, ram[i + 1].address);
+                s.size = end - s.address;
+                s.segment = seg.name;
+                break;
+            }
+        }
+    }
+
+    symbols.swap(ram);
+}
+
+struct Budget {
+    const char* name;
+    double used;
+    long limit;
+    bool minimum = false; // used must be at least the limit instead
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long data_budget = 224;
+    long xdata_budget = 512;
+    long code_budget = 8192;
+    long direct_budget = 128;
+    long stack_budget = 32;
+    const char* map_path = nullptr;
+    const char* out_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        auto value = [&](long& v) {
+            if (i + 1 < argc)
+                v = std::strtol(argv[++i], nullptr, 0);
+        };
+        if (!std::strcmp(argv[i], "--data"))
+            value(data_budget);
+        else if (!std::strcmp(argv[i], "--xdata"))
+            value(xdata_budget);
+        else if (!std::strcmp(argv[i], "--code"))
+            value(code_budget);
+        else if (!std::strcmp(argv[i], "--direct"))
+            value(direct_budget);
+        else if (!std::strcmp(argv[i], "--stack"))
+            value(stack_budget);
+        else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+            out_path = argv[++i];
+        else
+            map_path = argv[i];
+    }
+
+    if (!map_path) {
+        std::fprintf(stderr, "usage: memreport [--data N] [--xdata N] [--code N] [--direct N] [--stack N] [-o report.txt] project-three.m51\n");
+        return 2;
+    }
+
+    std::ifstream in(map_path);
+    if (!in) {
+        std::fprintf(stderr, "memreport: cannot open %s\n", map_path);
+        return 2;
+    }
+
+    std::vector<Segment> segments;
+    std::vector<Symbol> symbols;
+    Totals totals;
+    if (!parse_map(in, segments, symbols, totals)) {
+        std::fprintf(stderr, "memreport: %s does not look like a BL51 map file\n", map_path);
+        return 2;
+    }
+    size_symbols(segments, symbols);
+
+    // Totals from the segments, for map files without a Program Size line.
+    double seg_data = 0;
+    long seg_xdata = 0;
+    long seg_code = 0;
+    for (const auto& s : segments) {
+        if (s.type == "XDATA")
+            seg_xdata += long(s.length);
+        else if (s.type == "CODE")
+            seg_code += long(s.length);
+        else if (s.type == "BIT")
+            seg_data += s.length / 8.0;
+        else if (s.name != "?STACK")
+            seg_data += double(s.length);
+    }
+    if (totals.data < 0)
+        totals.data = seg_data;
+    if (totals.xdata < 0)
+        totals.xdata = seg_xdata;
+    if (totals.code < 0)
+        totals.code = seg_code;
+
+    // Where direct RAM use ends, and where the stack starts (the top of
+    // internal RAM if the map has no ?STACK).
+    unsigned long direct_top = 0;
+    unsigned long stack_base = 256;
+    for (const auto& s : segments) {
+        if (s.type == "REG" || s.type == "DATA")
+            direct_top = std::max(direct_top, s.base + s.length);
+        else if (s.type == "BIT")
+            direct_top = std::max(direct_top, s.base + (s.base_bit + s.length + 7) / 8);
+        if (s.name == "?STACK")
+            stack_base = s.base;
+    }
+
+    std::ostringstream out;
+    char line[160];
+
+    out << "Segments (largest first)\n";
+    std::vector<Segment> by_size = segments;
+    std::stable_sort(by_size.begin(), by_size.end(), [](const Segment& a, const Segment& b) { return a.length > b.length; });
+    for (const auto& s : by_size) {
+        if (s.name.empty() || s.name == "?STACK")
+            continue;
+        std::snprintf(line, sizeof line, "  %-6s %6lu%s  %s\n", s.type.c_str(), s.length, s.type == "BIT" ? " bits" : "", s.name.c_str());
+        out << line;
+    }
+
+    out << "\nRAM symbols (largest first)\n";
+    std::stable_sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) { return a.size > b.size; });
+    for (const auto& s : symbols) {
+        std::snprintf(line, sizeof line, "  %-5s %04lXH %5lu  %-24s %s\n", space_name(s.space).c_str(), s.address, s.size, s.name.c_str(), s.module.c_str());
+        out << line;
+    }
+
+    Budget budgets[] = {
+        { "data", totals.data, data_budget },
+        { "direct", double(direct_top), direct_budget },
+        { "stack", double(256 - std::min(stack_base, 256ul)), stack_budget, true },
+        { "xdata", double(totals.xdata), xdata_budget },
+        { "code", double(totals.code), code_budget },
+    };
+
+    int exceeded = 0;
+    out << "\nBudgets\n";
+    for (const auto& b : budgets) {
+        bool over = b.minimum ? b.used < double(b.limit) : b.used > double(b.limit);
+        if (b.minimum)
+            std::snprintf(line, sizeof line, "  %-6s %8.1f bytes, at least %4ld%s\n", b.name, b.used, b.limit, over ? "  *** TOO LITTLE ***" : "");
+        else
+            std::snprintf(line, sizeof line, "  %-6s %8.1f of %6ld bytes (%3.0f%%)%s\n", b.name, b.used, b.limit,
+                b.limit ? 100.0 * b.used / double(b.limit) : 0.0, over ? "  *** OVER BUDGET ***" : "");
+        out << line;
+        exceeded += over;
+    }
+
+    std::cout << out.str();
+    if (out_path) {
+        std::ofstream report(out_path);
+        report << out.str();
+    }
+
+    if (exceeded) {
+        std::fprintf(stderr, "*** ERROR: %d memory budget(s) exceeded\n", exceeded);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Host side of the binary board-state protocol described in src/proto.h.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "firmware.hpp"
+
+namespace c4 {
+
+inline std::uint8_t crc8(std::uint8_t crc, std::uint8_t value)
+{
+    crc ^= value;
+    for (int i = 0; i < 8; i++)
+        crc = (crc & 0x80) ? std::uint8_t((crc << 1) ^ PROTO_CRC_POLY) : std::uint8_t(crc << 1);
+    return crc;
+}
+
+struct Frame {
+    std::uint8_t type = 0;
+    std::uint8_t length = 0;
+    std::uint8_t payload[255] = {};
+};
+
+// Appends a complete frame (sync, header, payload, crc) to out.
+inline void encode_frame(std::string& out, std::uint8_t type, const std::uint8_t* payload, std::uint8_t length)
+{
+    std::uint8_t crc = crc8(crc8(0, type), length);
+    out.push_back(char(PROTO_SYNC));
+    out.push_back(char(type));
+    out.push_back(char(length));
+    for (std::uint8_t i = 0; i < length; i++) {
+        out.push_back(char(payload[i]));
+        crc = crc8(crc, payload[i]);
+    }
+    out.push_back(char(crc));
+}
+
+// Byte-at-a-time frame decoder. Complete frames with a good CRC go to
+// on_frame, bytes outside frames go to on_text, and a frame whose CRC does
+// not match is dropped and counted.
+class FrameParser {
+public:
+    std::function<void(const Frame&)> on_frame;
+    std::function<void(std::uint8_t)> on_text;
+
+    std::size_t frames = 0;
+    std::size_t crc_errors = 0;
+
+    void feed(const std::uint8_t* data, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i++)
+            feed(data[i]);
+    }
+
+    void feed(std::uint8_t b)
+    {
+        switch (state_) {
+        case State::Idle:
+            if (b == PROTO_SYNC)
+                state_ = State::Type;
+            else if (on_text)
+                on_text(b);
+            break;
+        case State::Type:
+            frame_.type = b;
+            crc_ = crc8(0, b);
+            state_ = State::Length;
+            break;
+        case State::Length:
+            frame_.length = b;
+            crc_ = crc8(crc_, b);
+            pos_ = 0;
+            state_ = b ? State::Payload : State::Crc;
+            break;
+        case State::Payload:
+            frame_.payload[pos_++] = b;
+            crc_ = crc8(crc_, b);
+            if (pos_ == frame_.length)
+                state_ = State::Crc;
+            break;
+        case State::Crc:
+            state_ = State::Idle;
+            if (b != crc_) {
+                crc_errors++;
+                break;
+            }
+            frames++;
+            if (on_frame)
+                on_frame(frame_);
+            break;
+        }
+    }
+
+private:
+    enum class State { Idle, Type, Length, Payload, Crc };
+
+    State state_ = State::Idle;
+    Frame frame_;
+    std::uint8_t crc_ = 0;
+    std::size_t pos_ = 0;
+};
+
+} // namespace c4
@@ -0,0 +1,132 @@
+// Host side rules engine, specialised per board geometry at compile time.
+//
+// Same board layout as the firmware (src/rules.h): one byte per column per
+// player, bit j is row j counted from the bottom. Width and height are
+// template parameters, so bounds are constants and the line checks unroll.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "firmware.hpp"
+
+namespace c4 {
+
+enum Player : std::uint8_t { X = 0, O = 1 };
+
+inline Player other(Player p) { return p == X ? O : X; }
+inline char piece_char(Player p) { return p == X ? 'X' : 'O'; }
+
+template <unsigned W, unsigned H>
+class Board {
+    static_assert(W >= 4 && W <= 9, "width must be 4..9, one column per button");
+    static_assert(H >= 4 && H <= 8, "height must be 4..8, one byte per column");
+
+public:
+    static constexpr unsigned width = W;
+    static constexpr unsigned height = H;
+    static constexpr unsigned cells = W * H;
+
+    using Columns = std::array<std::uint8_t, W>;
+
+    // Drops a piece; returns the row or -1 if the column is full.
+    int drop(unsigned col, Player p)
+    {
+        if (col >= W || heights_[col] >= H)
+            return -1;
+        int row = heights_[col]++;
+        cols_[p][col] |= std::uint8_t(1u << row);
+        moves_++;
+        return row;
+    }
+
+    // Takes the top piece back out of a column.
+    void undo(unsigned col)
+    {
+        std::uint8_t mask = std::uint8_t(1u << --heights_[col]);
+        cols_[X][col] &= std::uint8_t(~mask);
+        cols_[O][col] &= std::uint8_t(~mask);
+        moves_--;
+    }
+
+    bool can_drop(unsigned col) const { return col < W && heights_[col] < H; }
+    bool full() const { return moves_ == cells; }
+    bool wins(Player p) const { return wins(cols_[p]); }
+
+    unsigned moves() const { return moves_; }
+    unsigned column_height(unsigned col) const { return heights_[col]; }
+    const Columns& columns(Player p) const { return cols_[p]; }
+
+    // 'X', 'O' or ' '.
+    char at(unsigned col, unsigned row) const
+    {
+        std::uint8_t mask = std::uint8_t(1u << row);
+        if (cols_[X][col] & mask)
+            return 'X';
+        if (cols_[O][col] & mask)
+            return 'O';
+        return ' ';
+    }
+
+    static bool wins(const Columns& m)
+    {
+        return vertical(m, std::make_index_sequence<W>{}) || across(m, std::make_index_sequence<W - 3>{});
+    }
+
+private:
+    template <std::size_t... I>
+    static bool vertical(const Columns& m, std::index_sequence<I...>)
+    {
+        return ((m[I] & (m[I] >> 1) & (m[I] >> 2) & (m[I] >> 3)) | ...) != 0;
+    }
+
+    template <std::size_t... I>
+    static bool across(const Columns& m, std::index_sequence<I...>)
+    {
+        return ((window(m[I], m[I + 1], m[I + 2], m[I + 3])) | ...) != 0;
+    }
+
+    // Row, rising diagonal and falling diagonal through four columns.
+    static unsigned window(unsigned a, unsigned b, unsigned c, unsigned d)
+    {
+        return (a & b & c & d) | (a & (b >> 1) & (c >> 2) & (d >> 3)) | (a & (b << 1) & (c << 2) & (d << 3));
+    }
+
+    std::array<Columns, 2> cols_ {};
+    Columns heights_ {};
+    unsigned moves_ = 0;
+};
+
+template <unsigned W, unsigned H>
+struct Geometry {
+    static constexpr unsigned width = W;
+    static constexpr unsigned height = H;
+    using board = Board<W, H>;
+};
+
+// Calls f(Geometry<W, H>{}) for every GEOMETRIES entry in src/config.h.
+template <class F>
+void for_each_geometry(F&& f)
+{
+#define C4_VISIT_GEOMETRY(w, h) f(Geometry<w, h> {});
+    GEOMETRIES(C4_VISIT_GEOMETRY)
+#undef C4_VISIT_GEOMETRY
+}
+
+// Calls f(Geometry<W, H>{}) for the GEOMETRIES entry matching width and
+// height. Returns false if there is none.
+template <class F>
+bool with_geometry(unsigned width, unsigned height, F&& f)
+{
+    bool found = false;
+    for_each_geometry([&](auto g) {
+        if (!found && g.width == width && g.height == height) {
+            found = true;
+            f(g);
+        }
+    });
+    return found;
+}
+
+} // namespace c4
@@ -0,0 +1,44 @@
+// Opening the board's serial port (or a pty standing in for it).
+#pragma once
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace c4 {
+
+// termios speed for a baud rate, 0 if unsupported.
+inline speed_t to_speed(long baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return 0;
+    }
+}
+
+// Opens a serial device raw at the given baud rate. Anything that is not
+// a terminal (a pipe, a file) is opened as it is. Returns -1 on failure
+// with errno set.
+inline int open_serial(const char* path, long baud, int flags = O_RDONLY)
+{
+    int fd = open(path, flags | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, to_speed(baud));
+        cfsetospeed(&tio, to_speed(baud));
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+} // namespace c4
@@ -0,0 +1,301 @@
+// sessions - plays a game in every remote session of one board at once.
+//
+// The board hosts SESSION_COUNT games for remote players besides the one
+// on its buttons (src/session.h), each driven by CMD_ frames and answered
+// with a MSG_SESSION frame (src/proto.h). This opens every session and
+// plays random moves in them in turn, one command at a time as the board
+// wants, until each has finished -l games. Every answer is checked against
+// host/rules.hpp: the row the piece landed in, the side to move, the win
+// or the draw. Moves into full columns, commands for closed sessions and
+// out of range ones are thrown in as well and must be refused without
+// changing anything.
+//
+// The board's own output (text or frames for the game on its buttons)
+// goes past untouched, so someone can play there meanwhile. A vboard pty
+// works as the device too.
+//
+// Build: g++ -std=c++17 -O2 -o sessions host/sessions.cpp
+// Usage: sessions [-b baud] [-l games] [-s seed] device
+//        (default 9600 baud, 10 games a session)
+
+#include "protocol.hpp"
+#include "rules.hpp"
+#include "serial.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+const std::uint8_t NONE = 0xFF;
+
+// One session as the board should have it.
+struct Game {
+    unsigned geometry = 0;
+    unsigned width = 0;
+    unsigned height = 0;
+    std::uint8_t heights[9] = {};
+    std::uint8_t cols[2][9] = {};
+    unsigned moves = 0;
+    std::uint8_t state = SESSION_CLOSED;
+    std::uint8_t side = ' ';
+    unsigned games = 0;
+};
+
+struct Answer {
+    std::uint8_t session = 0;
+    std::uint8_t state = 0;
+    std::uint8_t col = 0;
+    std::uint8_t row = 0;
+    std::uint8_t side = 0;
+};
+
+class Board {
+public:
+    explicit Board(int fd)
+        : fd_(fd)
+    {
+        parser_.on_frame = [this](const c4::Frame& f) {
+            if (f.type == MSG_SESSION && f.length == 5) {
+                answer_ = { f.payload[0], f.payload[1], f.payload[2], f.payload[3], f.payload[4] };
+                answered_ = true;
+            }
+        };
+    }
+
+    // Sends a command and waits up to two seconds for its answer.
+    bool ask(std::uint8_t type, std::uint8_t a, std::uint8_t b, std::uint8_t length, Answer& answer, double& ms)
+    {
+        std::string out;
+        std::uint8_t payload[2] = { a, b };
+        c4::encode_frame(out, type, payload, length);
+        auto start = std::chrono::steady_clock::now();
+        if (write(fd_, out.data(), out.size()) != ssize_t(out.size()))
+            return false;
+
+        answered_ = false;
+        std::uint8_t buf[256];
+        while (!answered_) {
+            pollfd p = { fd_, POLLIN, 0 };
+            int r = poll(&p, 1, 2000);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                return false;
+            ssize_t n = read(fd_, buf, sizeof buf);
+            if (n <= 0)
+                return false;
+            parser_.feed(buf, std::size_t(n));
+        }
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        answer = answer_;
+        return true;
+    }
+
+private:
+    int fd_;
+    c4::FrameParser parser_;
+    Answer answer_;
+    bool answered_ = false;
+};
+
+bool wins(const Game& g, unsigned side)
+{
+    bool won = false;
+    c4::with_geometry(g.width, g.height, [&](auto geometry) {
+        using B = typename decltype(geometry)::board;
+        typename B::Columns m;
+        std::copy(g.cols[side], g.cols[side] + B::width, m.begin());
+        won = B::wins(m);
+    });
+    return won;
+}
+
+struct Run {
+    Board* board = nullptr;
+    std::mt19937 rng;
+    std::vector<double> ms;
+    std::size_t commands = 0;
+    std::size_t refusals = 0;
+    std::size_t mismatches = 0;
+
+    // Sends a command and compares the answer with what it should be.
+    bool check(const char* what, std::uint8_t type, std::uint8_t a, std::uint8_t b, std::uint8_t length, const Answer& want)
+    {
+        Answer got;
+        double t;
+        if (!board->ask(type, a, b, length, got, t)) {
+            std::fprintf(stderr, "sessions: no answer to %s %u %u\n", what, a, b);
+            return false;
+        }
+        commands++;
+        ms.push_back(t);
+        if (got.session != want.session || got.state != want.state || got.col != want.col || got.row != want.row
+            || got.side != want.side) {
+            mismatches++;
+            std::fprintf(stderr, "sessions: %s %u %u: got %u state %u col %u row %u side '%c', want %u %u %u %u '%c'\n", what, a,
+                b, got.session, got.state, got.col, got.row, got.side, want.session, want.state, want.col, want.row,
+                want.side);
+        }
+        return true;
+    }
+
+    bool open(unsigned n, Game& g)
+    {
+        std::vector<std::pair<unsigned, unsigned>> sizes;
+        c4::for_each_geometry([&](auto geometry) { sizes.emplace_back(geometry.width, geometry.height); });
+        unsigned games = g.games;
+        g = Game {};
+        g.games = games;
+        g.geometry = unsigned(rng() % sizes.size());
+        g.width = sizes[g.geometry].first;
+        g.height = sizes[g.geometry].second;
+        g.state = SESSION_PLAYING;
+        g.side = 'X';
+        return check("open", CMD_OPEN, std::uint8_t(n), std::uint8_t(g.geometry), 2,
+            { std::uint8_t(n), SESSION_PLAYING, NONE, NONE, 'X' });
+    }
+
+    // A random move, now and then into a full column to be refused.
+    bool move(unsigned n, Game& g)
+    {
+        std::vector<unsigned> open_cols, full_cols;
+        for (unsigned c = 0; c < g.width; c++)
+            (g.heights[c] < g.height ? open_cols : full_cols).push_back(c);
+
+        if (!full_cols.empty() && rng() % 8 == 0) {
+            refusals++;
+            unsigned c = full_cols[rng() % full_cols.size()];
+            return check("move", CMD_MOVE, std::uint8_t(n), std::uint8_t(c), 2,
+                { std::uint8_t(n), SESSION_REFUSED, std::uint8_t(c), NONE, g.side });
+        }
+
+        unsigned c = open_cols[rng() % open_cols.size()];
+        unsigned side = g.moves % 2;
+        std::uint8_t row = g.heights[c]++;
+        g.cols[side][c] |= std::uint8_t(1u << row);
+        g.moves++;
+        if (wins(g, side)) {
+            g.state = SESSION_WON;
+        } else if (g.moves == g.width * g.height) {
+            g.state = SESSION_DRAW;
+            g.side = ' ';
+        } else {
+            g.side = side ? 'X' : 'O';
+        }
+        return check("move", CMD_MOVE, std::uint8_t(n), std::uint8_t(c), 2, { std::uint8_t(n), g.state, std::uint8_t(c), row, g.side });
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    std::size_t i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    long baud = 9600;
+    unsigned games = 10;
+    unsigned seed = 1;
+    const char* device = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            baud = std::strtol(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "-l") && i + 1 < argc)
+            games = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (argv[i][0] != '-' && !device)
+            device = argv[i];
+        else {
+            std::fprintf(stderr, "usage: sessions [-b baud] [-l games] [-s seed] device\n");
+            return 2;
+        }
+    }
+    if (!device) {
+        std::fprintf(stderr, "usage: sessions [-b baud] [-l games] [-s seed] device\n");
+        return 2;
+    }
+    if (!c4::to_speed(baud)) {
+        std::fprintf(stderr, "sessions: unsupported baud rate %ld\n", baud);
+        return 2;
+    }
+    int fd = c4::open_serial(device, baud, O_RDWR);
+    if (fd < 0) {
+        std::fprintf(stderr, "sessions: %s: %s\n", device, std::strerror(errno));
+        return 1;
+    }
+
+    Board board(fd);
+    Run run;
+    run.board = &board;
+    run.rng.seed(seed);
+    std::vector<Game> sessions(SESSION_COUNT);
+    auto start = std::chrono::steady_clock::now();
+
+    // nothing is open yet, and there is no session or size past the last
+    const std::uint8_t last = SESSION_COUNT;
+    std::uint8_t no_size = 0;
+    c4::for_each_geometry([&](auto) { no_size++; });
+    bool ok = run.check("move", CMD_MOVE, 0, 0, 2, { 0, SESSION_REFUSED, 0, NONE, ' ' })
+        && run.check("open", CMD_OPEN, last, 0, 2, { last, SESSION_REFUSED, NONE, NONE, ' ' })
+        && run.check("open", CMD_OPEN, 0, no_size, 2, { 0, SESSION_REFUSED, NONE, NONE, ' ' });
+    run.refusals += 3;
+
+    for (unsigned n = 0; ok && n < sessions.size(); n++)
+        ok = run.open(n, sessions[n]);
+
+    // a move in each session in turn, restarting each game as it ends
+    std::size_t finished = 0;
+    while (ok && finished < sessions.size()) {
+        for (unsigned n = 0; ok && n < sessions.size(); n++) {
+            Game& g = sessions[n];
+            if (g.state == SESSION_CLOSED)
+                continue;
+            if (g.state == SESSION_PLAYING) {
+                ok = run.move(n, g);
+                continue;
+            }
+            // over: a move must be refused, then the next game or the end
+            run.refusals++;
+            ok = run.check("move", CMD_MOVE, std::uint8_t(n), 0, 2, { std::uint8_t(n), SESSION_REFUSED, 0, NONE, g.side });
+            if (ok && ++g.games < games) {
+                ok = run.open(n, g);
+            } else if (ok) {
+                g.state = SESSION_CLOSED;
+                g.side = ' ';
+                finished++;
+                ok = run.check("close", CMD_CLOSE, std::uint8_t(n), 0, 1, { std::uint8_t(n), SESSION_CLOSED, NONE, NONE, ' ' });
+            }
+        }
+    }
+    close(fd);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(run.ms.begin(), run.ms.end());
+    std::printf("%zu sessions, %zu games, %zu commands (%zu refusals) in %.1f s, %.1f commands/s\n", sessions.size(),
+        std::size_t(sessions.size()) * games, run.commands, run.refusals, seconds, double(run.commands) / seconds);
+    if (!run.ms.empty())
+        std::printf("round trip ms: min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", run.ms.front(), percentile(run.ms, 50),
+            percentile(run.ms, 90), percentile(run.ms, 99), run.ms.back());
+    std::printf("%zu mismatches\n", run.mismatches);
+    return ok && !run.mismatches ? 0 : 1;
+}
@@ -0,0 +1,409 @@
+// strc - string compiler for the firmware's text messages.
+//
+// Reads the messages from src/messages.txt, one per line:
+//     NAME "text, with C escapes such as \r\n and \033"
+// (blank lines and lines starting with # are skipped) and writes them as
+// one table in code memory, src/texttab.c, with an ID for each in
+// src/texttab.h. An ID is where the message starts in the table, one
+// byte, so the table's messages must start in its first 256 bytes.
+// Messages with the same text share one entry, and one that is the end of
+// another (\r\n of a line) starts inside it.
+//
+// With -p the text is also compressed, with byte pair encoding. Text is
+// 7-bit ASCII, so the byte values TXT_FIRST_PAIR (0x80) and up are free
+// to stand for a pair of other bytes, each of which may be a pair in
+// turn. The most frequent adjacent pair is replaced by a new code as long
+// as that saves space, up to 128 pairs, and pairs nest at most -d deep.
+// src/text.c then expands them as the UART asks for bytes, with a stack
+// of that depth. The expander costs code of its own, so packing only pays
+// once there is far more text than the firmware has today; compare the
+// CODE size in the linker map with and without it.
+//
+// With --if, the tables are only built when that preprocessor condition
+// on src/config.h holds, so builds that print no text carry none.
+//
+// Build: g++ -std=c++17 -O2 -o strc host/strc.cpp
+// Usage: strc [-p] [-d depth] [--if condition] src/messages.txt src/texttab.c src/texttab.h
+//        (default plain text; with -p, depth 6)
+//
+// Run it again after editing messages.txt; the output is committed.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const unsigned first_pair = 0x80;
+const unsigned max_pairs = 0x100 - first_pair;
+// text_id is an unsigned char
+const std::size_t max_id = 0xFF;
+
+struct Message {
+    std::string name;
+    std::string text;
+    std::size_t entry = 0; // index into the unique texts
+};
+
+// Parses one quoted C string starting at s[i] (the opening quote).
+bool unquote(const std::string& s, std::size_t& i, std::string& out, std::string& error)
+{
+    i++;
+    while (i < s.size() && s[i] != '"') {
+        char c = s[i++];
+        if (c != '\\') {
+            out.push_back(c);
+            continue;
+        }
+        if (i >= s.size())
+            break;
+        char e = s[i++];
+        switch (e) {
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case '\\': out.push_back('\\'); break;
+        case '"': out.push_back('"'); break;
+        case 'x': {
+            unsigned v = 0;
+            int digits = 0;
+            while (digits < 2 && i < s.size() && std::isxdigit((unsigned char)s[i])) {
+                v = v * 16 + unsigned(std::isdigit((unsigned char)s[i]) ? s[i] - '0' : (s[i] | 0x20) - 'a' + 10);
+                i++;
+                digits++;
+            }
+            out.push_back(char(v));
+            break;
+        }
+        default:
+            if (e >= '0' && e <= '7') {
+                unsigned v = unsigned(e - '0');
+                for (int digits = 1; digits < 3 && i < s.size() && s[i] >= '0' && s[i] <= '7'; digits++)
+                    v = v * 8 + unsigned(s[i++] - '0');
+                out.push_back(char(v));
+            } else {
+                error = std::string("unknown escape \\") + e;
+                return false;
+            }
+        }
+    }
+    if (i >= s.size()) {
+        error = "missing closing quote";
+        return false;
+    }
+    i++;
+    return true;
+}
+
+bool read_messages(const char* path, std::vector<Message>& messages)
+{
+    std::ifstream in(path);
+    if (!in) {
+        std::fprintf(stderr, "strc: cannot open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        std::size_t i = line.find_first_not_of(" \t\r");
+        if (i == std::string::npos || line[i] == '#')
+            continue;
+
+        Message m;
+        while (i < line.size() && (std::isalnum((unsigned char)line[i]) || line[i] == '_'))
+            m.name.push_back(line[i++]);
+        i = line.find_first_not_of(" \t", i);
+
+        std::string error;
+        if (m.name.empty())
+            error = "expected a name";
+        else if (i == std::string::npos || line[i] != '"')
+            error = "expected a quoted string after the name";
+        else if (unquote(line, i, m.text, error) && line.find_first_not_of(" \t\r", i) != std::string::npos)
+            error = "text after the string";
+        for (char c : m.text)
+            if (error.empty() && (c == 0 || (unsigned char)c >= first_pair))
+                error = "only 7-bit characters other than NUL can be packed";
+        for (const Message& other : messages)
+            if (error.empty() && other.name == m.name)
+                error = m.name + " is already defined";
+
+        if (!error.empty()) {
+            std::fprintf(stderr, "%s:%d: %s\n", path, number, error.c_str());
+            return false;
+        }
+        messages.push_back(m);
+    }
+    if (messages.empty() || messages.size() > max_id) {
+        std::fprintf(stderr, "strc: %s: need 1 to %zu messages, a text_id is one byte\n", path, max_id);
+        return false;
+    }
+    return true;
+}
+
+struct Packed {
+    std::vector<std::vector<unsigned>> texts; // symbols, pairs >= first_pair
+    std::vector<std::pair<unsigned, unsigned>> pairs;
+    unsigned depth = 0;
+};
+
+// Replaces the most frequent pair while it saves more than the two bytes
+// its table entry costs.
+Packed pack(const std::vector<std::string>& texts, unsigned max_depth)
+{
+    Packed p;
+    std::vector<unsigned> depth(0x100, 0);
+    for (const std::string& t : texts)
+        p.texts.emplace_back(t.begin(), t.end());
+
+    while (p.pairs.size() < max_pairs) {
+        // counted without overlap, the way they would be replaced
+        std::map<std::pair<unsigned, unsigned>, unsigned> counts;
+        for (const auto& t : p.texts) {
+            for (std::size_t i = 0; i + 1 < t.size(); i++) {
+                if (std::max(depth[t[i]], depth[t[i + 1]]) + 1 > max_depth)
+                    continue;
+                counts[{ t[i], t[i + 1] }]++;
+                if (i + 2 < t.size() && t[i] == t[i + 1] && t[i + 1] == t[i + 2])
+                    i++;
+            }
+        }
+
+        // first of the most frequent, so the output does not change from
+        // run to run
+        std::pair<unsigned, unsigned> best;
+        unsigned best_count = 0;
+        for (const auto& c : counts)
+            if (c.second > best_count) {
+                best = c.first;
+                best_count = c.second;
+            }
+        if (best_count < 3)
+            break;
+
+        unsigned code = first_pair + unsigned(p.pairs.size());
+        p.pairs.push_back(best);
+        depth[code] = std::max(depth[best.first], depth[best.second]) + 1;
+        p.depth = std::max(p.depth, depth[code]);
+
+        for (auto& t : p.texts) {
+            std::vector<unsigned> out;
+            for (std::size_t i = 0; i < t.size(); i++) {
+                if (i + 1 < t.size() && t[i] == best.first && t[i + 1] == best.second) {
+                    out.push_back(code);
+                    i++;
+                } else {
+                    out.push_back(t[i]);
+                }
+            }
+            t.swap(out);
+        }
+    }
+    return p;
+}
+
+std::string byte_literal(unsigned b)
+{
+    char buf[8];
+    if (b >= first_pair || b < 0x20 || b == '\'' || b == '\\' || b >= 0x7F)
+        std::snprintf(buf, sizeof buf, "0x%02X", b);
+    else
+        std::snprintf(buf, sizeof buf, "'%c'", char(b));
+    return buf;
+}
+
+// The text for a comment, escapes spelled out.
+std::string escaped(const std::string& text)
+{
+    std::string out;
+    for (char c : text) {
+        char buf[8];
+        if (c == '\r')
+            out += "\\r";
+        else if (c == '\n')
+            out += "\\n";
+        else if ((unsigned char)c < 0x20 || c == 0x7F) {
+            std::snprintf(buf, sizeof buf, "\\%03o", unsigned(c));
+            out += buf;
+        } else
+            out.push_back(c);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bool packed = false;
+    unsigned max_depth = 6;
+    const char* condition = nullptr;
+    std::vector<const char*> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-p"))
+            packed = true;
+        else if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+            max_depth = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--if") && i + 1 < argc)
+            condition = argv[++i];
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.size() != 3 || max_depth < 1 || max_depth > 16) {
+        std::fprintf(stderr, "usage: strc [-p] [-d depth] [--if condition] messages.txt texttab.c texttab.h\n");
+        return 2;
+    }
+    const char* header_name = std::strrchr(paths[2], '/') ? std::strrchr(paths[2], '/') + 1 : paths[2];
+
+    std::vector<Message> messages;
+    if (!read_messages(paths[0], messages))
+        return 1;
+
+    std::vector<std::string> texts;
+    std::size_t raw = 0;
+    for (Message& m : messages) {
+        auto same = std::find(texts.begin(), texts.end(), m.text);
+        m.entry = std::size_t(same - texts.begin());
+        if (same == texts.end())
+            texts.push_back(m.text);
+        raw += m.text.size() + 1;
+    }
+
+    // no pair can be 0 deep, so plain text comes back as it is
+    Packed p = pack(texts, packed ? max_depth : 0);
+
+    // Entries that are the end of a longer one start inside it. Owners are
+    // picked longest first, then laid out in messages.txt order.
+    std::vector<std::size_t> owner(p.texts.size());
+    std::vector<std::size_t> longest(p.texts.size());
+    for (std::size_t e = 0; e < longest.size(); e++)
+        longest[e] = e;
+    std::stable_sort(longest.begin(), longest.end(), [&](std::size_t a, std::size_t b) { return p.texts[a].size() > p.texts[b].size(); });
+    for (std::size_t i = 0; i < longest.size(); i++) {
+        const auto& t = p.texts[longest[i]];
+        owner[longest[i]] = longest[i];
+        for (std::size_t j = 0; j < i; j++) {
+            const auto& o = p.texts[longest[j]];
+            if (owner[longest[j]] == longest[j] && std::equal(t.rbegin(), t.rend(), o.rbegin())) {
+                owner[longest[i]] = longest[j];
+                break;
+            }
+        }
+    }
+    std::vector<std::size_t> start(p.texts.size());
+    std::size_t size = 0;
+    for (std::size_t e = 0; e < p.texts.size(); e++) {
+        if (owner[e] == e) {
+            start[e] = size;
+            size += p.texts[e].size() + 1;
+        }
+    }
+    for (std::size_t e = 0; e < p.texts.size(); e++)
+        start[e] = start[owner[e]] + p.texts[owner[e]].size() - p.texts[e].size();
+
+    for (const Message& m : messages) {
+        if (start[m.entry] > max_id) {
+            std::fprintf(stderr, "strc: TXT_%s starts at byte %zu, past what a one-byte text_id holds\n", m.name.c_str(), start[m.entry]);
+            return 1;
+        }
+    }
+
+    FILE* c = std::fopen(paths[1], "w");
+    FILE* h = std::fopen(paths[2], "w");
+    if (!c || !h) {
+        std::fprintf(stderr, "strc: cannot write %s\n", c ? paths[2] : paths[1]);
+        return 1;
+    }
+
+    std::fprintf(h, "#ifndef _TEXTTABH_\n#define _TEXTTABH_\n\n");
+    std::fprintf(h, "// Generated by host/strc from %s, do not edit.\n\n", paths[0]);
+    std::fprintf(h, "#include \"compiler.h\"\n\n");
+    for (std::size_t i = 0; i < messages.size(); i++)
+        std::fprintf(h, "#define TXT_%-12s %zu // \"%s\"\n", messages[i].name.c_str(), start[messages[i].entry],
+            escaped(messages[i].text).c_str());
+    std::fprintf(h, "\n// A message ID is where the message starts in text_data, it ends at a 0.\n");
+    std::fprintf(h, "typedef unsigned char text_id;\n\n");
+    if (packed) {
+        std::fprintf(h, "// Codes from TXT_FIRST_PAIR up stand for text_pairs[code - TXT_FIRST_PAIR],\n");
+        std::fprintf(h, "// nested at most TXT_MAX_DEPTH deep.\n");
+        std::fprintf(h, "#define TXT_FIRST_PAIR 0x%02X\n", first_pair);
+        std::fprintf(h, "#define TXT_MAX_DEPTH  %u\n\n", std::max(p.depth, 1u));
+    } else {
+        std::fprintf(h, "// Plain text, no pairs to expand.\n");
+        std::fprintf(h, "#define TXT_MAX_DEPTH  0\n\n");
+    }
+    std::fprintf(h, "extern const unsigned char code text_data[%zu];\n", size);
+    if (packed)
+        std::fprintf(h, "extern const unsigned char code text_pairs[%zu][2];\n", std::max<std::size_t>(p.pairs.size(), 1));
+    std::fprintf(h, "\n#endif // _TEXTTABH_\n");
+
+    std::fprintf(c, "// Generated by host/strc from %s, do not edit.\n", paths[0]);
+    if (packed)
+        std::fprintf(c, "// %zu messages in %zu bytes of text and %zu of pairs, %zu bytes unpacked.\n\n", messages.size(), size,
+            p.pairs.size() * 2, raw);
+    else
+        std::fprintf(c, "// %zu messages in %zu bytes, %zu bytes one by one.\n\n", messages.size(), size, raw);
+    std::fprintf(c, "#include \"compiler.h\"\n");
+    if (condition)
+        std::fprintf(c, "#include \"config.h\"\n");
+    std::fprintf(c, "#include \"%s\"\n\n", header_name);
+    if (condition)
+        std::fprintf(c, "#if %s\n\n", condition);
+
+    std::fprintf(c, "const unsigned char code text_data[%zu] =\n{\n", size);
+    std::size_t last = 0;
+    for (std::size_t e = 0; e < p.texts.size(); e++)
+        if (owner[e] == e)
+            last = e;
+    for (std::size_t e = 0; e < p.texts.size(); e++) {
+        if (owner[e] != e)
+            continue;
+        // the ones starting inside it too, at the end
+        std::string names;
+        for (const Message& m : messages)
+            if (owner[m.entry] == e)
+                names += (names.empty() ? "TXT_" : ", TXT_") + m.name;
+        std::fprintf(c, "\t// %s\n", names.c_str());
+        std::string line = "\t";
+        for (unsigned s : p.texts[e])
+            line += byte_literal(s) + ", ";
+        line += e != last ? "0," : "0";
+        std::fprintf(c, "%s\n", line.c_str());
+    }
+    std::fprintf(c, "};\n");
+
+    if (packed) {
+        std::fprintf(c, "\nconst unsigned char code text_pairs[%zu][2] =\n{\n", std::max<std::size_t>(p.pairs.size(), 1));
+        if (p.pairs.empty())
+            std::fprintf(c, "\t{ 0, 0 }\n");
+        for (std::size_t i = 0; i < p.pairs.size(); i++)
+            std::fprintf(c, "\t{ %s, %s }%s // 0x%02zX\n", byte_literal(p.pairs[i].first).c_str(), byte_literal(p.pairs[i].second).c_str(),
+                i + 1 < p.pairs.size() ? "," : "", first_pair + i);
+        std::fprintf(c, "};\n");
+    }
+    if (condition)
+        std::fprintf(c, "\n#endif\n");
+
+    bool ok = !std::ferror(c) && !std::ferror(h);
+    ok = std::fclose(c) == 0 && ok;
+    ok = std::fclose(h) == 0 && ok;
+    if (!ok) {
+        std::fprintf(stderr, "strc: write failed\n");
+        return 1;
+    }
+
+    if (packed)
+        std::printf("%zu messages, %zu unique, %zu bytes unpacked, %zu packed + %zu of pairs, depth %u\n", messages.size(), texts.size(), raw,
+            size, p.pairs.size() * 2, p.depth);
+    else
+        std::printf("%zu messages, %zu unique, %zu bytes unpacked, %zu in the table\n", messages.size(), texts.size(), raw, size);
+    return 0;
+}
@@ -0,0 +1,457 @@
+// train - learns the evaluation table the firmware scores moves with.
+//
+// For every GEOMETRIES entry this plays games against itself and fits a
+// value to every cell for each side: how much an X, or an O, in that cell
+// is worth towards winning. A position is worth the sum over its pieces,
+// X's values counted for X and O's against, and the fit is a logistic
+// regression of that sum on how each game ended (a win is 1, a loss 0, a
+// draw a half), over every position of every game. The board is the same
+// mirrored left to right, so each column shares its values with its mirror.
+//
+// Games are played by an engine that wins when it can, blocks when it
+// must and avoids handing the opponent a win on top of its own piece.
+// Otherwise it picks at random, weighting each move by the value of the
+// cell it lands in. There are -n rounds of -g games each: the first round
+// weighs moves the way ponder.c did before the tables, more the nearer
+// the centre, and every later one by the table fitted so far. Some moves
+// are made at random whatever the weights, so every cell gets played.
+//
+// After each round the values are scaled so the largest is EVAL_MAX,
+// below the scores ponder.c reserves for wins, and rounded to signed
+// bytes. The rounded table then plays -m games against the centre
+// weighting, half of them as X, always taking the move it values most,
+// and the round that comes out furthest ahead is written out. src/eval.c
+// looks the values up: scoring a move is one table read. The board uses
+// the scores to pick the column hints.
+//
+// Build: g++ -std=c++17 -O2 -o train host/train.cpp
+// Usage: train [-g games] [-n rounds] [-m games] [-s seed] src/evaltab.c src/evaltab.h
+//        (default 4000 games, 8 rounds, 1000 games against the centre)
+//
+// Run it again after changing GEOMETRIES; the output is committed.
+
+#include "rules.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The largest value in the tables; ponder.h's PONDER_WIN is 100.
+const int eval_max = 99;
+
+struct Options {
+    unsigned games = 4000;
+    unsigned rounds = 8;
+    unsigned match = 1000;
+    double epsilon = 0.1;     // share of moves made at random
+    double temperature = 0.3; // of the weighting by value
+    double rate = 0.01;
+    unsigned steps = 300;
+};
+
+// Cells with their own value: the left half of the board and the centre
+// column, column by column from the bottom.
+template <class B>
+constexpr unsigned half_cells()
+{
+    return (B::width + 1) / 2 * B::height;
+}
+
+template <class B>
+unsigned half_cell(unsigned col, unsigned row)
+{
+    if (col >= B::width - col)
+        col = B::width - 1 - col;
+    return col * B::height + row;
+}
+
+// What a move is worth to the side making it.
+struct Scoring {
+    virtual ~Scoring() = default;
+    virtual double value(c4::Player p, unsigned cell) const = 0;
+};
+
+struct Table : Scoring {
+    std::vector<double> w; // X's cells, then O's
+
+    explicit Table(unsigned cells) : w(2 * cells) {}
+    double value(c4::Player p, unsigned cell) const override { return w[p * (w.size() / 2) + cell]; }
+};
+
+// ponder.c before the tables: more the nearer the centre.
+template <class B>
+struct Centre : Scoring {
+    double value(c4::Player, unsigned cell) const override
+    {
+        int centre = B::width / 2;
+        int col = int(cell / B::height);
+        return centre - std::abs(col - centre);
+    }
+};
+
+struct Move {
+    std::uint8_t cell; // half_cell()
+    c4::Player player;
+};
+
+struct Game {
+    std::vector<Move> moves;
+    double result = 0.5; // for X
+};
+
+// Picks a move for p, or returns -1 if the board is full. temperature 0
+// takes the best value, ties at random.
+template <class B>
+int choose(B& b, c4::Player p, const Scoring& s, std::mt19937& rng, double temperature, double epsilon)
+{
+    c4::Player o = c4::other(p);
+    std::vector<unsigned> legal;
+    for (unsigned c = 0; c < B::width; c++)
+        if (b.can_drop(c))
+            legal.push_back(c);
+    if (legal.empty())
+        return -1;
+
+    for (unsigned c : legal) {
+        b.drop(c, p);
+        bool won = b.wins(p);
+        b.undo(c);
+        if (won)
+            return int(c);
+    }
+    for (unsigned c : legal) {
+        b.drop(c, o);
+        bool lost = b.wins(o);
+        b.undo(c);
+        if (lost)
+            return int(c);
+    }
+
+    std::vector<unsigned> safe;
+    for (unsigned c : legal) {
+        b.drop(c, p);
+        bool gives = false;
+        if (b.can_drop(c)) {
+            b.drop(c, o);
+            gives = b.wins(o);
+            b.undo(c);
+        }
+        b.undo(c);
+        if (!gives)
+            safe.push_back(c);
+    }
+    if (safe.empty())
+        safe = legal;
+
+    std::uniform_real_distribution<double> u(0, 1);
+    if (u(rng) < epsilon)
+        return int(safe[rng() % safe.size()]);
+
+    std::vector<double> v;
+    for (unsigned c : safe)
+        v.push_back(s.value(p, half_cell<B>(c, b.column_height(c))));
+    double best = *std::max_element(v.begin(), v.end());
+    if (temperature <= 0) {
+        std::vector<unsigned> top;
+        for (std::size_t i = 0; i < safe.size(); i++)
+            if (v[i] == best)
+                top.push_back(safe[i]);
+        return int(top[rng() % top.size()]);
+    }
+    double sum = 0;
+    for (double& x : v) {
+        x = std::exp((x - best) / temperature);
+        sum += x;
+    }
+    double r = u(rng) * sum;
+    for (std::size_t i = 0; i < safe.size(); i++) {
+        r -= v[i];
+        if (r <= 0)
+            return int(safe[i]);
+    }
+    return int(safe.back());
+}
+
+// Plays one game, X scored by sx and O by so. The first opening moves
+// are random so that games between fixed players differ.
+template <class B>
+Game play(const Scoring& sx, const Scoring& so, std::mt19937& rng, double temperature, double epsilon, unsigned opening)
+{
+    B b;
+    Game g;
+    c4::Player p = c4::X;
+    for (;;) {
+        int c;
+        if (g.moves.size() < opening) {
+            std::vector<unsigned> legal;
+            for (unsigned k = 0; k < B::width; k++)
+                if (b.can_drop(k))
+                    legal.push_back(k);
+            c = int(legal[rng() % legal.size()]);
+        } else {
+            c = choose(b, p, p == c4::X ? sx : so, rng, temperature, epsilon);
+        }
+        if (c < 0)
+            return g; // a draw
+        int row = b.drop(unsigned(c), p);
+        g.moves.push_back({ std::uint8_t(half_cell<B>(unsigned(c), unsigned(row))), p });
+        if (b.wins(p)) {
+            g.result = p == c4::X ? 1.0 : 0.0;
+            return g;
+        }
+        p = c4::other(p);
+    }
+}
+
+double sigmoid(double x) { return 1 / (1 + std::exp(-x)); }
+
+// Mean log loss over every position of the games.
+double loss(const Table& t, const std::vector<Game>& games)
+{
+    double sum = 0;
+    std::size_t n = 0;
+    for (const Game& g : games) {
+        double score = 0;
+        for (const Move& m : g.moves) {
+            score += (m.player == c4::X ? 1 : -1) * t.value(m.player, m.cell);
+            double q = std::min(std::max(sigmoid(score), 1e-9), 1 - 1e-9);
+            sum -= g.result * std::log(q) + (1 - g.result) * std::log(1 - q);
+            n++;
+        }
+    }
+    return n ? sum / double(n) : 0;
+}
+
+// Gradient descent on the mean log loss over all positions at once, with
+// Adam's step sizes.
+void fit(Table& t, const std::vector<Game>& games, const Options& opt)
+{
+    unsigned half = unsigned(t.w.size() / 2);
+    std::vector<double> grad(t.w.size()), m(t.w.size()), v(t.w.size());
+    std::vector<double> err;
+    const double b1 = 0.9, b2 = 0.999;
+    double p1 = 1, p2 = 1;
+    for (unsigned step = 0; step < opt.steps; step++) {
+        std::fill(grad.begin(), grad.end(), 0.0);
+        std::size_t positions = 0;
+        for (const Game& g : games) {
+            // d(score after k moves)/dw is the sign of every move up to k,
+            // so each move's term gathers the errors of all that follow
+            err.resize(g.moves.size());
+            double score = 0;
+            for (std::size_t k = 0; k < g.moves.size(); k++) {
+                const Move& mv = g.moves[k];
+                score += (mv.player == c4::X ? 1 : -1) * t.value(mv.player, mv.cell);
+                err[k] = sigmoid(score) - g.result;
+            }
+            double tail = 0;
+            for (std::size_t k = g.moves.size(); k-- > 0;) {
+                tail += err[k];
+                const Move& mv = g.moves[k];
+                grad[mv.player * half + mv.cell] += (mv.player == c4::X ? 1 : -1) * tail;
+            }
+            positions += g.moves.size();
+        }
+        p1 *= b1;
+        p2 *= b2;
+        for (std::size_t i = 0; i < t.w.size(); i++) {
+            double gi = grad[i] / double(std::max<std::size_t>(positions, 1)) + 1e-4 * t.w[i];
+            m[i] = b1 * m[i] + (1 - b1) * gi;
+            v[i] = b2 * v[i] + (1 - b2) * gi * gi;
+            t.w[i] -= opt.rate * (m[i] / (1 - p1)) / (std::sqrt(v[i] / (1 - p2)) + 1e-8);
+        }
+    }
+}
+
+struct Result {
+    std::string name;
+    unsigned width = 0;
+    unsigned height = 0;
+    std::vector<int> cells[2];
+    unsigned round = 0;
+    double loss_before = 0;
+    double loss_after = 0;
+    unsigned won = 0, drawn = 0, lost = 0;
+};
+
+// Scaled so the largest value is eval_max, then rounded.
+Table quantise(const Table& t)
+{
+    double top = 0;
+    for (double w : t.w)
+        top = std::max(top, std::fabs(w));
+    Table q(unsigned(t.w.size() / 2));
+    for (std::size_t i = 0; i < t.w.size(); i++)
+        q.w[i] = top > 0 ? double(std::lround(t.w[i] * eval_max / top)) : 0;
+    return q;
+}
+
+// Keeps the round whose table does best against the centre weighting; a
+// better fit to the games does not always make a better greedy player.
+template <class B>
+Result train(const Options& opt, std::mt19937& rng)
+{
+    Result best;
+    const unsigned half = half_cells<B>();
+    Table t(half);
+    Centre<B> centre;
+    std::vector<Game> games;
+    bool any = false;
+
+    for (unsigned round = 0; round < opt.rounds; round++) {
+        Result r;
+        r.width = B::width;
+        r.height = B::height;
+        r.name = std::to_string(B::width) + "x" + std::to_string(B::height);
+        r.round = round + 1;
+
+        // the first round learns from the centre weighting's games
+        games.clear();
+        for (unsigned i = 0; i < opt.games; i++) {
+            if (round == 0)
+                games.push_back(play<B>(centre, centre, rng, 1.0, opt.epsilon, 0));
+            else
+                games.push_back(play<B>(t, t, rng, opt.temperature, opt.epsilon, 0));
+        }
+        r.loss_before = loss(Table(half), games);
+        fit(t, games, opt);
+        r.loss_after = loss(t, games);
+
+        Table q = quantise(t);
+        for (unsigned p = 0; p < 2; p++)
+            for (unsigned i = 0; i < half; i++)
+                r.cells[p].push_back(int(q.w[p * half + i]));
+        for (unsigned i = 0; i < opt.match; i++) {
+            bool as_x = i % 2 == 0;
+            Game g = as_x ? play<B>(q, centre, rng, 0, 0, 2) : play<B>(centre, q, rng, 0, 0, 2);
+            double mine = as_x ? g.result : 1 - g.result;
+            if (mine == 1)
+                r.won++;
+            else if (mine == 0)
+                r.lost++;
+            else
+                r.drawn++;
+        }
+
+        if (!any || int(r.won) - int(r.lost) > int(best.won) - int(best.lost))
+            best = r;
+        any = true;
+    }
+    return best;
+}
+
+bool write_files(const std::vector<Result>& results, const Options& opt, unsigned seed, const char* c_path, const char* h_path)
+{
+    std::FILE* c = std::fopen(c_path, "w");
+    std::FILE* h = std::fopen(h_path, "w");
+    if (!c || !h) {
+        std::fprintf(stderr, "train: cannot write %s\n", c ? h_path : c_path);
+        return false;
+    }
+    const char* header_name = std::strrchr(h_path, '/') ? std::strrchr(h_path, '/') + 1 : h_path;
+
+    std::size_t cells = 0;
+    for (const Result& r : results)
+        cells += r.cells[0].size();
+
+    std::fprintf(h, "#ifndef _EVALTABH_\n#define _EVALTABH_\n\n");
+    std::fprintf(h, "// Generated by host/train, do not edit.\n\n");
+    std::fprintf(h, "#include \"compiler.h\"\n#include \"rules.h\"\n\n");
+    std::fprintf(h, "// No entry is bigger than this either way.\n");
+    std::fprintf(h, "#define EVAL_MAX %d\n\n", eval_max);
+    std::fprintf(h, "// For each geometry the cells of the left half of the board and the\n");
+    std::fprintf(h, "// centre column, column by column from the bottom, starting at\n");
+    std::fprintf(h, "// eval_start[geometry]. The first table is X's, the second O's.\n");
+    std::fprintf(h, "#define EVAL_CELLS %zu\n\n", cells);
+    std::fprintf(h, "extern const unsigned char code eval_start[GEOM_COUNT];\n");
+    std::fprintf(h, "extern const signed char code eval_cells[2][EVAL_CELLS];\n\n");
+    std::fprintf(h, "#endif // _EVALTABH_\n");
+
+    std::fprintf(c, "// Generated by host/train, do not edit.\n");
+    std::fprintf(c, "// Seed %u, %u rounds of %u games for each geometry.\n\n", seed, opt.rounds, opt.games);
+    std::fprintf(c, "#include \"compiler.h\"\n#include \"rules.h\"\n#include \"%s\"\n\n", header_name);
+    std::fprintf(c, "const unsigned char code eval_start[GEOM_COUNT] =\n{\n\t");
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < results.size(); i++) {
+        std::fprintf(c, "%zu%s", start, i + 1 < results.size() ? ", " : "\n");
+        start += results[i].cells[0].size();
+    }
+    std::fprintf(c, "};\n\n");
+    std::fprintf(c, "const signed char code eval_cells[2][EVAL_CELLS] =\n{\n");
+    for (unsigned p = 0; p < 2; p++) {
+        std::fprintf(c, "\t// %c\n\t{\n", p ? 'O' : 'X');
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            std::fprintf(c, "\t\t// %s\n", r.name.c_str());
+            for (unsigned col = 0; col < (r.width + 1) / 2; col++) {
+                std::string line = "\t\t";
+                for (unsigned row = 0; row < r.height; row++) {
+                    char v[8];
+                    bool last = i + 1 == results.size() && col + 1 == (r.width + 1) / 2 && row + 1 == r.height;
+                    std::snprintf(v, sizeof v, "%d%s", r.cells[p][col * r.height + row], last ? "" : ",");
+                    if (row)
+                        line += ' ';
+                    line += v;
+                }
+                std::fprintf(c, "%s\n", line.c_str());
+            }
+        }
+        std::fprintf(c, "\t}%s\n", p ? "" : ",");
+    }
+    std::fprintf(c, "};\n");
+
+    bool ok = !std::ferror(c) && !std::ferror(h);
+    ok = std::fclose(c) == 0 && ok;
+    ok = std::fclose(h) == 0 && ok;
+    if (!ok)
+        std::fprintf(stderr, "train: write failed\n");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    unsigned seed = 1;
+    const char* paths[2] = { nullptr, nullptr };
+    int n = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-g") && i + 1 < argc)
+            opt.games = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            opt.rounds = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+            opt.match = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        else if (argv[i][0] != '-' && n < 2)
+            paths[n++] = argv[i];
+        else
+            n = 3;
+    }
+    if (n != 2 || !opt.games || !opt.rounds) {
+        std::fprintf(stderr, "usage: train [-g games] [-n rounds] [-m games] [-s seed] evaltab.c evaltab.h\n");
+        return 2;
+    }
+
+    std::mt19937 rng(seed);
+    std::vector<Result> results;
+    c4::for_each_geometry([&](auto geometry) {
+        using B = typename decltype(geometry)::board;
+        results.push_back(train<B>(opt, rng));
+        const Result& r = results.back();
+        std::printf("%s: round %u, loss %.4f -> %.4f, against the centre %u won %u drawn %u lost\n", r.name.c_str(), r.round,
+            r.loss_before, r.loss_after, r.won, r.drawn, r.lost);
+    });
+
+    return write_files(results, opt, seed, paths[0], paths[1]) ? 0 : 1;
+}
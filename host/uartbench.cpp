@@ -0,0 +1,249 @@
+// uartbench - runs the board's UART self-test at each rate and reports it.
+//
+// For every rate of UART_BAUDS (src/uart.h) this sends the board 'U' and
+// the rate's digit, follows it to that rate and takes in what it streams
+// for UART_TEST_MS: a counting pattern, checked byte by byte. With -l it
+// sends 'L' instead and a counting pattern of its own, which the board
+// echoes back. Afterwards, at the usual rate again, the board reports what
+// it sent and received, how many received bytes its buffer had no room
+// for, and the UART interrupts taken and the timer 0 counts (machine
+// cycles) spent in them. For each rate this prints
+//
+//     line     the line rate, baud / 10 bytes a second
+//     out      bytes a second the board got out, and the share of the line;
+//              with -l only what is echoed, which stops 150 ms early
+//     lost     bytes the board sent that never arrived here, or arrived
+//              out of sequence
+//     echoed   with -l, the share of the bytes sent from here the board got
+//     dropped  bytes the board's receive buffer had no room for
+//     isr      share of the CPU in the UART interrupt, and cycles per call
+//
+// A vboard pty (host/vboard.cpp) works as the device too; it has no
+// interrupt, so isr reads 0 there.
+//
+// Build: g++ -std=c++17 -O2 -o uartbench host/uartbench.cpp
+// Usage: uartbench [-l] [-r rate]... device
+//        (every rate by default)
+
+#include "firmware.hpp"
+#include "serial.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+#define UARTBENCH_RATE(baud) baud,
+const long rates[UART_BAUD_COUNT] = { UART_BAUDS(UARTBENCH_RATE) };
+#undef UARTBENCH_RATE
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+bool set_rate(int fd, long baud)
+{
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0)
+        return true; // not a terminal, nothing to set
+    cfsetispeed(&tio, c4::to_speed(baud));
+    cfsetospeed(&tio, c4::to_speed(baud));
+    return tcsetattr(fd, TCSADRAIN, &tio) == 0;
+}
+
+// What the board reported, "u 04 2D00 03E8 0000 0000 2D01 0004A2C4".
+struct Report {
+    unsigned rate = 0;
+    unsigned sent = 0;
+    unsigned ms = 0;
+    unsigned received = 0;
+    unsigned dropped = 0;
+    unsigned calls = 0;
+    unsigned long isr = 0;
+};
+
+// Counts a counting pattern as it comes in. A byte out of sequence counts
+// as lost and the count carries on from it.
+struct Pattern {
+    unsigned char next = 0;
+    std::size_t good = 0;
+    std::size_t bad = 0;
+
+    void feed(const unsigned char* p, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i++) {
+            if (p[i] == next)
+                good++;
+            else
+                bad++;
+            next = static_cast<unsigned char>(p[i] + 1);
+        }
+    }
+};
+
+// Reads the report line, up to two seconds.
+bool read_report(int fd, Report& r)
+{
+    std::string line;
+    auto start = Clock::now();
+    while (ms_since(start) < 2000) {
+        pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        char c;
+        if (read(fd, &c, 1) != 1)
+            continue;
+        if (c != '\n') {
+            if (line.size() < 80)
+                line.push_back(c);
+            continue;
+        }
+        if (std::sscanf(line.c_str(), "u %2x %4x %4x %4x %4x %4x %8lx", &r.rate, &r.sent, &r.ms, &r.received, &r.dropped,
+                &r.calls, &r.isr)
+            == 7)
+            return true;
+        line.clear();
+    }
+    return false;
+}
+
+// One test at one rate. Returns false if the board did not answer.
+bool run(int fd, unsigned index, bool loopback, Report& report, Pattern& in, std::size_t& out)
+{
+    tcflush(fd, TCIOFLUSH);
+    char command[2] = { loopback ? 'L' : 'U', char('0' + index) };
+    if (write(fd, command, 2) != 2)
+        return false;
+    tcdrain(fd);
+    set_rate(fd, rates[index]);
+
+    // the board waits UART_SETTLE_MS before it starts; the echo is sent
+    // for a little less than the test so all of it can come back
+    auto start = Clock::now();
+    const double begin = UART_SETTLE_MS + 50;
+    const double end = UART_SETTLE_MS + UART_TEST_MS - 100;
+    const double give_up = UART_SETTLE_MS + UART_TEST_MS + 500;
+    auto heard = Clock::now();
+    bool any = false;
+    unsigned char counter = 0;
+    unsigned char buf[512];
+
+    for (;;) {
+        double t = ms_since(start);
+        if (t > give_up || (any && ms_since(heard) > 200))
+            break;
+        bool sending = loopback && t >= begin && t < end;
+        pollfd p = { fd, short(POLLIN | (sending ? POLLOUT : 0)), 0 };
+        if (poll(&p, 1, sending ? 1 : 10) < 0)
+            continue;
+        if (p.revents & POLLIN) {
+            ssize_t n = read(fd, buf, sizeof buf);
+            if (n > 0) {
+                in.feed(buf, std::size_t(n));
+                any = true;
+                heard = Clock::now();
+            }
+        }
+        // at the line rate, which a pty would not hold anyone to
+        std::size_t due = std::size_t((t - begin) * double(rates[index]) / 10000.0);
+        if (sending && (p.revents & POLLOUT) && due > out) {
+            unsigned char chunk[16];
+            std::size_t want = std::min(sizeof chunk, due - out);
+            for (std::size_t i = 0; i < want; i++)
+                chunk[i] = static_cast<unsigned char>(counter + i);
+            ssize_t n = write(fd, chunk, want);
+            if (n > 0) {
+                out += std::size_t(n);
+                counter = static_cast<unsigned char>(counter + n);
+            }
+        }
+    }
+
+    set_rate(fd, rates[UART_BAUD_DEFAULT]);
+    return read_report(fd, report);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bool loopback = false;
+    std::vector<unsigned> which;
+    const char* device = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-l")) {
+            loopback = true;
+        } else if (!std::strcmp(argv[i], "-r") && i + 1 < argc) {
+            long baud = std::strtol(argv[++i], nullptr, 10);
+            unsigned k = 0;
+            while (k < UART_BAUD_COUNT && rates[k] != baud)
+                k++;
+            if (k == UART_BAUD_COUNT) {
+                std::fprintf(stderr, "uartbench: the board has no %ld baud\n", baud);
+                return 2;
+            }
+            which.push_back(k);
+        } else if (argv[i][0] != '-' && !device) {
+            device = argv[i];
+        } else {
+            std::fprintf(stderr, "usage: uartbench [-l] [-r rate]... device\n");
+            return 2;
+        }
+    }
+    if (!device) {
+        std::fprintf(stderr, "usage: uartbench [-l] [-r rate]... device\n");
+        return 2;
+    }
+    if (which.empty())
+        for (unsigned k = 0; k < UART_BAUD_COUNT; k++)
+            which.push_back(k);
+
+    int fd = c4::open_serial(device, rates[UART_BAUD_DEFAULT], O_RDWR);
+    if (fd < 0) {
+        std::fprintf(stderr, "uartbench: %s: %s\n", device, std::strerror(errno));
+        return 1;
+    }
+
+    // machine cycles in a millisecond, the timer 0 counts of a tick
+    const double cycles_per_ms = double(65536ul - TICK_RELOAD);
+
+    std::printf("%-8s %8s %8s %6s %6s %8s %7s %6s %10s\n", "rate", "line", "out", "%", "lost", loopback ? "echoed %" : "",
+        "dropped", "isr %", "cycles/isr");
+    int status = 0;
+    for (unsigned k : which) {
+        Report r;
+        Pattern in;
+        std::size_t out = 0;
+        if (!run(fd, k, loopback, r, in, out)) {
+            std::fprintf(stderr, "uartbench: no report from the board at %ld baud\n", rates[k]);
+            status = 1;
+            continue;
+        }
+        double line = double(rates[k]) / 10;
+        double rate = r.ms ? r.sent * 1000.0 / r.ms : 0;
+        std::size_t arrived = in.good + in.bad;
+        std::size_t lost = (r.sent > arrived ? r.sent - arrived : 0) + in.bad;
+        std::printf("%-8ld %8.0f %8.0f %6.1f %6zu ", rates[k], line, rate, 100 * rate / line, lost);
+        if (loopback)
+            std::printf("%8.1f", out ? 100.0 * r.received / double(out) : 0);
+        else
+            std::printf("%8s", "");
+        std::printf(" %7u %6.2f %10.1f\n", r.dropped, r.ms ? 100.0 * double(r.isr) / (r.ms * cycles_per_ms) : 0,
+            r.calls ? double(r.isr) / r.calls : 0);
+    }
+    close(fd);
+    return status;
+}
@@ -0,0 +1,784 @@
+// vboard - many virtual Simon 2b boards running the game firmware, for
+// load testing.
+//
+// Every board is a process of its own running the firmware's tasks
+// (src/game.c, render.c, audio.c, ponder.c, console.c and what they use,
+// compiled in below) in the main loop's order. The firmware keeps all its
+// state in globals, so a process per board gives each board its own copy,
+// as each real board has its own RAM. Only the hardware underneath is
+// replaced:
+//
+//   UART     a pty, <dir>/board-N.tty. Bytes go out no faster than the baud
+//            rate allows (-b, 0 for no limit, though the UART self-test's
+//            rates are always kept) and anything typed into the pty
+//            reaches the serial commands (console.h), 'T' and all.
+//   buttons, LEDs, speaker
+//            a Unix socket, <dir>/board-N.sock, one line per event:
+//              in:  "press N"     a debounced press of button N
+//              out: "led X"       led_control(), X, O, a (size prompt) or -
+//                   "hint MASK"   led_columns(), the lit columns in hex
+//                   "win 0|1"     the win LED
+//                   "tone HZ"     the speaker starts a note
+//                   "quiet"       and stops
+//   tick     the host's monotonic clock.
+//
+// A board sleeps while it has nothing to send or play and otherwise wakes
+// every -q milliseconds, running the tasks a few times over. The link to a
+// second board is left out.
+//
+// With -l, vboard is also the load generator: it opens every board's pty
+// and socket like any client would and plays -l games on each, at random,
+// with up to -t ms of thinking before each press. A move counts from
+// sending the press to the board having been drawn (text mode) or its
+// MSG_MOVE frame arriving (binary mode). At the end it reports throughput
+// and the latency over all moves and per board. Without -l the boards run
+// until interrupted.
+//
+// Build: g++ -std=c++17 -O2 -o vboard host/vboard.cpp
+//        (add -DOUTPUT_MODE=1 for boards in binary mode)
+// Usage: vboard [-n boards] [-d dir] [-b baud] [-q ms] [-l games] [-t ms] [-s seed]
+//        (default 4 boards, /tmp/vboard, 9600 baud, 2 ms, no load)
+
+// The link needs a second board and an I2C bus (see host/linksim.cpp).
+#define LINK_ENABLE 0
+
+#include "protocol.hpp"
+#include "rules.hpp"
+#include "serial.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// The firmware. firmware.hpp has already undefined the memory classes,
+// so they are defined away again around the sources.
+#define code
+#define data
+#define idata
+#define xdata
+extern "C" {
+#include "../src/io.h"
+#include "../src/uart.h"
+#include "../src/tone.h"
+#include "../src/proto.c"
+#include "../src/rules.c"
+#include "../src/evaltab.c"
+#include "../src/eval.c"
+#include "../src/ponder.c"
+#include "../src/threat.c"
+#include "../src/trace.c"
+#include "../src/text.c"
+#include "../src/texttab.c"
+#include "../src/render.c"
+#include "../src/audio.c"
+#include "../src/session.c"
+#include "../src/console.c"
+#include "../src/game.c"
+}
+#undef code
+#undef data
+#undef idata
+#undef xdata
+
+namespace {
+
+std::uint64_t now_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::uint64_t(ts.tv_sec) * 1000000u + std::uint64_t(ts.tv_nsec) / 1000u;
+}
+
+struct Options {
+    unsigned boards = 4;
+    std::string dir = "/tmp/vboard";
+    long baud = 9600;
+    unsigned quantum_ms = 2;
+    unsigned games = 0;
+    unsigned think_ms = 0;
+    unsigned seed = 1;
+};
+
+std::string tty_path(const Options& o, unsigned n) { return o.dir + "/board-" + std::to_string(n) + ".tty"; }
+std::string sock_path(const Options& o, unsigned n) { return o.dir + "/board-" + std::to_string(n) + ".sock"; }
+
+// The hardware of the board this process is.
+struct Hardware {
+    std::uint64_t start_us = 0;
+    std::uint64_t quantum_us = 0;
+    std::uint64_t byte_us = 0; // 10 bits at the baud rate
+    long baud = 0; // -b, the board's own rate
+    bool uart_test = false; // switched to a self-test rate
+    std::uint64_t tx_free_us = 0; // when the UART can start the next byte
+    std::string tx; // sent, not yet in the pty
+    std::deque<unsigned char> rx;
+    unsigned char pressed = NO_BUTTON;
+    char led = '-';
+    unsigned hints = 0; // with led 'h'
+    unsigned char win = 0;
+    int pty = -1;
+    std::vector<int> clients;
+};
+
+Hardware hw;
+
+// One event line to every client; a client that cannot keep up misses it.
+void event(const char* fmt, unsigned value)
+{
+    char line[32];
+    int n = std::snprintf(line, sizeof line, fmt, value);
+    for (int fd : hw.clients)
+        send(fd, line, std::size_t(n), MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+} // namespace
+
+// The firmware's view of the hardware: tick.h, uart.h, io.h and tone.h.
+extern "C" {
+
+void tick_init() {}
+
+unsigned int tick_now() { return (unsigned int)((now_us() - hw.start_us) / 1000u); }
+
+unsigned int tick_since(unsigned int start) { return tick_now() - start; }
+
+unsigned int tick_fine(unsigned char* fine)
+{
+    std::uint64_t us = now_us() - hw.start_us;
+    *fine = (unsigned char)(us % 1000u * TICK_FINE_MAX / 1000u);
+    return (unsigned int)(us / 1000u);
+}
+
+unsigned char uart_ready() { return now_us() >= hw.tx_free_us; }
+
+// A byte starts when the last one is done, unless the board slept past
+// that by more than its wake-up quantum, which the real one would not.
+void uart_transmit(unsigned char value)
+{
+    std::uint64_t now = now_us();
+    std::uint64_t start = std::max(hw.tx_free_us, now > hw.quantum_us ? now - hw.quantum_us : 0);
+    hw.tx_free_us = start + hw.byte_us;
+    hw.tx.push_back(char(value));
+}
+
+// The usual rate is -b. The self-test (render.c) switches to one of its
+// rates and back, one call each; the test rate is paced as asked even
+// with -b 0, so uartbench measures what it expects.
+void uart_baud(unsigned char index)
+{
+#define VBOARD_BAUD(baud) baud,
+    static const long rates[UART_BAUD_COUNT] = { UART_BAUDS(VBOARD_BAUD) };
+#undef VBOARD_BAUD
+    hw.uart_test = !hw.uart_test;
+    long baud = hw.uart_test ? rates[index] : hw.baud;
+    hw.byte_us = baud ? 10000000u / std::uint64_t(baud) : 0;
+}
+
+void uart_init()
+{
+    hw.uart_test = false;
+    hw.byte_us = hw.baud ? 10000000u / std::uint64_t(hw.baud) : 0;
+}
+
+// No interrupt, nothing to count.
+void uart_stats(unsigned char* out) { std::fill(out, out + UART_STATS, 0); }
+
+unsigned char uart_received() { return !hw.rx.empty(); }
+
+unsigned char uart_get()
+{
+    unsigned char value = hw.rx.front();
+    hw.rx.pop_front();
+    return value;
+}
+
+void io_init() {}
+
+void led_control(unsigned char ctrl)
+{
+    hw.led = ctrl ? char(ctrl) : '-';
+    event("led %c\n", (unsigned char)hw.led);
+}
+
+void led_columns(unsigned int cols)
+{
+    hw.led = 'h';
+    hw.hints = cols;
+    event("hint %03x\n", cols);
+}
+
+void win_led(unsigned char on)
+{
+    hw.win = on;
+    event("win %u\n", on);
+}
+
+// Presses come from the socket already debounced.
+unsigned char read_button() { return NO_BUTTON; }
+
+char input_task() { return 0; }
+
+unsigned char input_get()
+{
+    unsigned char pressed = hw.pressed;
+    hw.pressed = NO_BUTTON;
+    return pressed;
+}
+
+void tone_init() {}
+
+// Timer 1 counts at OSC_FREQ / 2 from the reload up to the overflow, twice
+// a period.
+void tone_start(unsigned char high, unsigned char low)
+{
+    unsigned counts = 65536u - (unsigned(high) << 8 | low);
+    event("tone %u\n", unsigned(OSC_FREQ / 2 / (2 * counts)));
+}
+
+void tone_stop() { event("quiet\n", 0); }
+
+} // extern "C"
+
+namespace {
+
+// One turn of the main loop, as in src/connect-four.c.
+void step()
+{
+    input_task();
+    game_task();
+    render_task();
+    audio_task();
+    console_task();
+    ponder_task();
+}
+
+int listen_on(const std::string& path)
+{
+    sockaddr_un addr {};
+    if (path.size() >= sizeof addr.sun_path)
+        return -1;
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(fd, 16) < 0)
+        return -1;
+    return fd;
+}
+
+// Runs board n until the parent goes away, powering it up once start
+// reaches its end. Never returns.
+[[noreturn]] void run_board(const Options& o, unsigned n, int ready, int start)
+{
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+    // The board keeps the pty's terminal end open itself, so the pty does
+    // not hang up between clients.
+    hw.pty = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    const char* name = hw.pty >= 0 && grantpt(hw.pty) == 0 && unlockpt(hw.pty) == 0 ? ptsname(hw.pty) : nullptr;
+    int terminal = name ? open(name, O_RDWR | O_NOCTTY | O_CLOEXEC) : -1;
+    termios tio;
+    if (terminal >= 0 && tcgetattr(terminal, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(terminal, TCSANOW, &tio);
+    }
+    std::string tty = tty_path(o, n);
+    unlink(tty.c_str());
+    int listener = listen_on(sock_path(o, n));
+    if (terminal < 0 || symlink(name, tty.c_str()) < 0 || listener < 0) {
+        std::fprintf(stderr, "vboard: board %u: %s\n", n, std::strerror(errno));
+        _exit(1);
+    }
+    if (write(ready, "", 1) != 1)
+        _exit(1);
+    close(ready);
+    char c;
+    while (read(start, &c, 1) > 0) {
+    }
+    close(start);
+
+    hw.start_us = now_us();
+    hw.quantum_us = o.quantum_ms * 1000u;
+    hw.baud = o.baud;
+
+    // init() of src/connect-four.c, less the link
+    uart_init();
+    io_init();
+    tick_init();
+    audio_init();
+    trace_init();
+    render_init();
+    console_init();
+#if SESSION_ENABLE
+    session_init();
+#endif
+    game_init();
+
+    std::string pending; // of a client's line, one client at a time is plenty
+    for (;;) {
+        for (int i = 0; i < 16; i++)
+            step();
+
+        if (!hw.tx.empty()) {
+            // nobody reading: the bytes are gone, as on a real serial line
+            ssize_t w = write(hw.pty, hw.tx.data(), hw.tx.size());
+            hw.tx.erase(0, w > 0 ? std::size_t(w) : hw.tx.size());
+        }
+
+        bool busy = !render_idle() || audio_busy() || !hw.tx.empty() || hw.pressed != NO_BUTTON;
+        if (!busy) {
+            // let the analysis of the position finish before sleeping
+            for (int i = 0; i < 256; i++)
+                step();
+            busy = !render_idle() || !hw.tx.empty();
+        }
+
+        std::vector<pollfd> fds;
+        fds.push_back({ hw.pty, POLLIN, 0 });
+        fds.push_back({ listener, POLLIN, 0 });
+        for (int fd : hw.clients)
+            fds.push_back({ fd, POLLIN, 0 });
+        if (poll(fds.data(), fds.size(), busy ? int(o.quantum_ms) : -1) < 0 && errno != EINTR)
+            _exit(1);
+
+        if (fds[0].revents & POLLIN) {
+            unsigned char buf[64];
+            ssize_t r = read(hw.pty, buf, sizeof buf);
+            for (ssize_t i = 0; i < r; i++)
+                hw.rx.push_back(buf[i]);
+        }
+        if (fds[1].revents & POLLIN) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                hw.clients.push_back(fd);
+                char line[32];
+                int len = hw.led == 'h' ? std::snprintf(line, sizeof line, "hint %03x\nwin %u\n", hw.hints, hw.win)
+                                        : std::snprintf(line, sizeof line, "led %c\nwin %u\n", hw.led, hw.win);
+                send(fd, line, std::size_t(len), MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+        }
+        for (std::size_t i = 2; i < fds.size(); i++) {
+            if (!fds[i].revents)
+                continue;
+            char buf[256];
+            ssize_t r = read(fds[i].fd, buf, sizeof buf);
+            if (r <= 0) {
+                close(fds[i].fd);
+                hw.clients.erase(std::find(hw.clients.begin(), hw.clients.end(), fds[i].fd));
+                continue;
+            }
+            pending.append(buf, std::size_t(r));
+            for (std::size_t nl; (nl = pending.find('\n')) != std::string::npos; pending.erase(0, nl + 1)) {
+                unsigned button;
+                if (std::sscanf(pending.c_str(), "press %u", &button) == 1 && button < NUM_BTNS) {
+                    hw.pressed = (unsigned char)button;
+                    TRACE(TRACE_PRESS, button);
+                }
+            }
+        }
+    }
+}
+
+// Plays games on one board through its pty and socket, as someone at a
+// terminal with the buttons would.
+struct Player {
+    unsigned board = 0;
+    int tty = -1;
+    int sock = -1;
+    c4::FrameParser parser;
+    std::string tail; // text mode: the last few bytes
+    bool drawing = false; // text mode: a board is coming in
+    unsigned lines = 0;
+    std::string line; // of events from the socket
+
+    unsigned width = 0;
+    unsigned height = 0;
+    std::uint8_t heights[MAX_WIDTH] = {};
+    std::uint8_t cols[2][MAX_WIDTH] = {};
+    unsigned moves = 0;
+    bool fresh = false; // the next board shown is a new game
+    unsigned games = 0;
+    bool done = false;
+
+    std::uint64_t press_at = 0; // when the next press is due, 0 for none
+    unsigned button = 0;
+    std::uint64_t pressed_at = 0; // a move on its way, 0 for none
+    std::vector<double> latency_ms;
+};
+
+struct Load {
+    const Options* options = nullptr;
+    std::mt19937 rng;
+    std::vector<Player> players;
+    std::size_t moves = 0;
+    std::size_t games = 0;
+    std::size_t bytes = 0;
+    std::map<std::string, std::size_t> events;
+
+    void press(Player& p, unsigned button)
+    {
+        p.button = button;
+        unsigned think = options->think_ms;
+        p.press_at = now_us() + (think ? rng() % (think * 1000u) : 0) + 1;
+    }
+
+    unsigned free_column(const Player& p)
+    {
+        unsigned free_cols[MAX_WIDTH];
+        unsigned n = 0;
+        for (unsigned c = 0; c < p.width; c++)
+            if (p.heights[c] < p.height)
+                free_cols[n++] = c;
+        return free_cols[rng() % n];
+    }
+
+    // The size prompt: pick one.
+    void select(Player& p)
+    {
+        unsigned size = rng() % GEOM_COUNT;
+        p.width = geom_width[size];
+        p.height = geom_height[size];
+        p.fresh = true;
+        press(p, size);
+    }
+
+    // A board is on screen, a new game's or the one after our move.
+    void shown(Player& p)
+    {
+        if (p.fresh) {
+            std::fill(p.heights, p.heights + MAX_WIDTH, 0);
+            std::fill(&p.cols[0][0], &p.cols[0][0] + sizeof p.cols, 0);
+            p.moves = 0;
+            p.fresh = false;
+            press(p, free_column(p));
+            return;
+        }
+        if (!p.pressed_at)
+            return;
+
+        p.latency_ms.push_back(double(now_us() - p.pressed_at) / 1000);
+        p.pressed_at = 0;
+        unsigned side = p.moves % 2;
+        p.cols[side][p.button] |= std::uint8_t(1u << p.heights[p.button]++);
+        p.moves++;
+        moves++;
+
+        // the result is on its way when the move ended the game
+        bool won = false;
+        c4::with_geometry(p.width, p.height, [&](auto g) {
+            using Board = typename decltype(g)::board;
+            typename Board::Columns m;
+            std::copy(p.cols[side], p.cols[side] + Board::width, m.begin());
+            won = Board::wins(m);
+        });
+        if (!won && p.moves < p.width * p.height)
+            press(p, free_column(p));
+    }
+
+    // Won or drawn; any button starts the next game at the same size.
+    void result(Player& p)
+    {
+        games++;
+        if (++p.games >= options->games) {
+            p.done = true;
+            return;
+        }
+        p.fresh = true;
+        press(p, rng() % NUM_BTNS);
+    }
+
+    void text(Player& p, std::uint8_t c)
+    {
+        p.tail.push_back(char(c));
+        if (p.tail.size() > 8)
+            p.tail.erase(0, 1);
+        auto ends = [&](const char* s) {
+            std::size_t n = std::strlen(s);
+            return p.tail.size() >= n && p.tail.compare(p.tail.size() - n, n, s) == 0;
+        };
+
+        if (ends("\033[2J\033[H")) {
+            p.drawing = true;
+            p.lines = 0;
+        } else if (ends("each:")) {
+            p.drawing = false;
+            select(p);
+        } else if (ends("wins!") || ends("draw!")) {
+            result(p);
+        } else if (c == '\n' && p.drawing && ++p.lines == 2 * p.height + 1) {
+            p.drawing = false;
+            shown(p);
+        }
+    }
+
+    void frame(Player& p, const c4::Frame& f)
+    {
+        if (f.type == MSG_SELECT)
+            select(p);
+        else if (f.type == MSG_NEW_GAME || f.type == MSG_MOVE)
+            shown(p);
+        else if (f.type == MSG_RESULT)
+            result(p);
+    }
+
+    void event(Player& p, const char* buf, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i++) {
+            if (buf[i] != '\n') {
+                p.line.push_back(buf[i]);
+                continue;
+            }
+            events[p.line.substr(0, p.line.find(' '))]++;
+            p.line.clear();
+        }
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    std::size_t i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+void report(Load& load, double seconds)
+{
+    const Options& o = *load.options;
+    std::printf("%u boards, %zu games, %zu moves in %.1f s\n", o.boards, load.games, load.moves, seconds);
+    std::printf("  %.1f moves/s, %.2f games/s, %.0f UART bytes/s\n", double(load.moves) / seconds, double(load.games) / seconds,
+        double(load.bytes) / seconds);
+
+    std::vector<double> all;
+    std::vector<std::pair<double, unsigned>> p99;
+    for (Player& p : load.players) {
+        std::sort(p.latency_ms.begin(), p.latency_ms.end());
+        all.insert(all.end(), p.latency_ms.begin(), p.latency_ms.end());
+        if (!p.latency_ms.empty())
+            p99.emplace_back(percentile(p.latency_ms, 99), p.board);
+    }
+    std::sort(all.begin(), all.end());
+    std::sort(p99.begin(), p99.end());
+    if (!all.empty()) {
+        std::printf("\npress to board: %zu, ms min %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f\n", all.size(), all.front(),
+            percentile(all, 50), percentile(all, 90), percentile(all, 99), all.back());
+        std::printf("p99 per board: best %.3f median %.3f worst %.3f (board %u)\n", p99.front().first,
+            p99[p99.size() / 2].first, p99.back().first, p99.back().second);
+    }
+
+    std::printf("\nevents:");
+    for (auto& e : load.events)
+        std::printf(" %s %zu", e.first.c_str(), e.second);
+    std::printf("\n");
+}
+
+// Plays until every board has had its games. Returns false if the boards
+// went quiet before that.
+bool play(Load& load, int start)
+{
+    const Options& o = *load.options;
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    load.players.resize(o.boards);
+    for (unsigned n = 0; n < o.boards; n++) {
+        Player& p = load.players[n];
+        p.board = n;
+        p.tty = c4::open_serial(tty_path(o, n).c_str(), 9600, O_RDWR | O_NONBLOCK);
+
+        sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, sock_path(o, n).c_str());
+        p.sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (p.tty < 0 || connect(p.sock, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0) {
+            std::fprintf(stderr, "vboard: board %u: %s\n", n, std::strerror(errno));
+            return false;
+        }
+
+        p.parser.on_text = [&load, &p](std::uint8_t c) { load.text(p, c); };
+        p.parser.on_frame = [&load, &p](const c4::Frame& f) { load.frame(p, f); };
+        epoll_event ev {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = std::uint64_t(n) << 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p.tty, &ev);
+        ev.data.u64 = std::uint64_t(n) << 1 | 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p.sock, &ev);
+    }
+
+    close(start);
+    std::uint64_t heard = now_us();
+
+    epoll_event evs[64];
+    for (;;) {
+        std::uint64_t now = now_us();
+        std::uint64_t next = now + 1000000u;
+        bool playing = false;
+        for (Player& p : load.players) {
+            if (p.done)
+                continue;
+            playing = true;
+            if (p.press_at && p.press_at <= now) {
+                char line[16];
+                int len = std::snprintf(line, sizeof line, "press %u\n", p.button);
+                if (write(p.sock, line, std::size_t(len)) != len)
+                    return false;
+                // only a column of a game in progress is timed
+                p.pressed_at = p.fresh ? 0 : now;
+                p.press_at = 0;
+            }
+            if (p.press_at)
+                next = std::min(next, p.press_at);
+        }
+        if (!playing)
+            return true;
+        if (now - heard > 10000000u) {
+            for (Player& p : load.players)
+                if (!p.done)
+                    std::fprintf(stderr, "vboard: board %u stuck after %u games, %u moves\n", p.board, p.games, p.moves);
+            return false;
+        }
+
+        int n = epoll_wait(ep, evs, 64, int((next - now + 999) / 1000));
+        for (int i = 0; i < n; i++) {
+            Player& p = load.players[evs[i].data.u64 >> 1];
+            std::uint8_t buf[4096];
+            ssize_t r = read(evs[i].data.u64 & 1 ? p.sock : p.tty, buf, sizeof buf);
+            if (r <= 0)
+                continue;
+            heard = now_us();
+            if (evs[i].data.u64 & 1) {
+                load.event(p, reinterpret_cast<const char*>(buf), std::size_t(r));
+            } else {
+                load.bytes += std::size_t(r);
+                p.parser.feed(buf, std::size_t(r));
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        auto number = [&] { return unsigned(std::strtoul(argv[++i], nullptr, 10)); };
+        if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            o.boards = number();
+        else if (!std::strcmp(argv[i], "-d") && i + 1 < argc)
+            o.dir = argv[++i];
+        else if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+            o.baud = long(number());
+        else if (!std::strcmp(argv[i], "-q") && i + 1 < argc)
+            o.quantum_ms = number();
+        else if (!std::strcmp(argv[i], "-l") && i + 1 < argc)
+            o.games = number();
+        else if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+            o.think_ms = number();
+        else if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+            o.seed = number();
+        else {
+            std::fprintf(stderr, "usage: vboard [-n boards] [-d dir] [-b baud] [-q ms] [-l games] [-t ms] [-s seed]\n");
+            return 2;
+        }
+    }
+    if (!o.boards || !o.quantum_ms) {
+        std::fprintf(stderr, "vboard: need at least one board and a quantum of 1 ms or more\n");
+        return 2;
+    }
+
+    // two descriptors a board here, with room to spare
+    rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    if (mkdir(o.dir.c_str(), 0777) < 0 && errno != EEXIST) {
+        std::fprintf(stderr, "vboard: %s: %s\n", o.dir.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    // Boards say they are ready on one pipe and power up when the other
+    // is closed, so the load generator sees them from the first byte.
+    int ready[2];
+    int start[2];
+    if (pipe2(ready, O_CLOEXEC) < 0 || pipe2(start, O_CLOEXEC) < 0)
+        return 1;
+    std::vector<pid_t> boards;
+    for (unsigned n = 0; n < o.boards; n++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(ready[0]);
+            close(start[1]);
+            run_board(o, n, ready[1], start[0]);
+        }
+        if (pid < 0) {
+            std::fprintf(stderr, "vboard: fork: %s\n", std::strerror(errno));
+            break;
+        }
+        boards.push_back(pid);
+    }
+    close(ready[1]);
+    close(start[0]);
+
+    // every board says so once its pty and socket are there
+    unsigned up = 0;
+    char c;
+    while (up < boards.size() && read(ready[0], &c, 1) == 1)
+        up++;
+
+    int status = 0;
+    if (up < o.boards) {
+        status = 1;
+    } else if (o.games) {
+        Load load;
+        load.options = &o;
+        load.rng.seed(o.seed);
+        std::uint64_t began = now_us();
+        if (!play(load, start[1]))
+            status = 1;
+        report(load, double(now_us() - began) / 1e6);
+    } else {
+        close(start[1]);
+        for (unsigned n = 0; n < o.boards; n++)
+            std::printf("board %u: %s %s\n", n, tty_path(o, n).c_str(), sock_path(o, n).c_str());
+        std::fflush(stdout);
+        sigset_t stop;
+        sigemptyset(&stop);
+        sigaddset(&stop, SIGINT);
+        sigaddset(&stop, SIGTERM);
+        sigprocmask(SIG_BLOCK, &stop, nullptr);
+        int sig;
+        sigwait(&stop, &sig);
+    }
+
+    for (pid_t pid : boards)
+        kill(pid, SIGTERM);
+    for (pid_t pid : boards)
+        waitpid(pid, nullptr, 0);
+    for (unsigned n = 0; n < o.boards; n++) {
+        unlink(tty_path(o, n).c_str());
+        unlink(sock_path(o, n).c_str());
+    }
+    return status;
+}
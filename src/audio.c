@@ -0,0 +1,130 @@
+#include "compiler.h"
+#include "audio.h"
+#include "tone.h"
+#include "pt.h"
+#include "tick.h"
+#include "trace.h"
+
+/*
+    Timer 1 reload for half a period of each note, and how long one play of
+    it lasts. The reloads are the ones delay_counts() used to spin on, and
+    one play was always about 31 ms of tone (the rest only about 8 ms).
+    Notes without a reload are not tuned, they are skipped like before.
+**/
+struct note
+{
+	unsigned char high;
+	unsigned char low;
+	unsigned char play_ms;
+};
+
+const struct note code notes[14] =
+{
+	{ 0x00, 0x00,  8 }, // 0 rest
+	{ 0xFC, 0x8F, 31 }, // 1 C5
+	{ 0x00, 0x00,  0 }, // 2
+	{ 0xFC, 0xEF, 31 }, // 3 D5
+	{ 0x00, 0x00,  0 }, // 4
+	{ 0xFD, 0x45, 31 }, // 5 E5
+	{ 0xFD, 0x6C, 31 }, // 6 F5
+	{ 0x00, 0x00,  0 }, // 7
+	{ 0xFD, 0xB4, 31 }, // 8 G5
+	{ 0x00, 0x00,  0 }, // 9
+	{ 0xFD, 0xF4, 31 }, // 10 A5
+	{ 0xFE, 0x11, 31 }, // 11 AS5
+	{ 0x00, 0x00,  0 }, // 12
+	{ 0xFE, 0x47, 31 }  // 13 C6
+};
+
+// Plays a tune on startup, happy sounding tune.
+const unsigned char code main_song[] =
+{
+	3,3, 2,4, 1,5, 5,3, 3,6, 8,2, 2,1, 9,9, 12,2, 4,8, 10,6, 12,12, SONG_END
+};
+
+// Plays a sad tune for both players as they lost.
+const unsigned char code draw_song[] =
+{
+	0,5, 11,5, 8,5, 5,5, 1,5, 0,15, SONG_END
+};
+
+// dododo you win! Play a happy tune for the winner.
+const unsigned char code win_song[] =
+{
+	9,9, 8,7, 12,5, 2,8, 4,8, SONG_END
+};
+
+static struct pt idata audio_pt;
+static const unsigned char code* data song;   // playing, 0 when quiet
+static const unsigned char code* idata queued; // asked for by audio_play()
+
+/*
+    Desc: Quiet, nothing queued.
+    @params: none
+**/
+void audio_init()
+{
+	tone_init();
+	song = 0;
+	queued = 0;
+	PT_INIT(&audio_pt);
+}
+
+/*
+    Desc: Start playing a song, replacing whatever is playing once the
+          current note is over.
+    @params: char* s - Pairs of (note, numb_plays) ended by SONG_END.
+**/
+void audio_play(const unsigned char code* s)
+{
+	queued = s;
+}
+
+/*
+    Desc: Whether a song is still playing.
+    @params: none
+**/
+unsigned char audio_busy()
+{
+	return song != 0 || queued != 0;
+}
+
+/*
+    Desc: Plays the song one note at a time, the other tasks run while a
+          note sounds.
+    @params: none
+**/
+char audio_task()
+{
+	static unsigned int idata start;
+	static unsigned int idata length;
+
+	PT_BEGIN(&audio_pt);
+
+	while (1)
+	{
+		PT_WAIT_UNTIL(&audio_pt, queued != 0);
+		song = queued;
+		queued = 0;
+		TRACE(TRACE_SONG, 0);
+
+		// a new song cuts this one off between notes
+		while (song[0] != SONG_END && queued == 0)
+		{
+			length = notes[song[0]].play_ms * song[1];
+			if (length)
+			{
+				if (notes[song[0]].high) tone_start(notes[song[0]].high, notes[song[0]].low);
+				start = tick_now();
+				PT_WAIT_UNTIL(&audio_pt, tick_since(start) >= length);
+				tone_stop();
+			}
+			song += 2;
+		}
+
+		song = 0;
+		TRACE(TRACE_QUIET, 0);
+	}
+
+	PT_END(&audio_pt);
+}
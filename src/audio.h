@@ -0,0 +1,27 @@
+#ifndef _AUDIOH_
+#define _AUDIOH_
+
+#include "compiler.h"
+
+// Tunes on the speaker. Timer 1 toggles the speaker in its interrupt
+// (tone.h), so a note plays in the background while the other tasks keep
+// running.
+
+// A song is pairs of (note, numb_plays) ended by SONG_END. Notes are
+// numbered as in play_note() of old: 0 is a rest, 1 is C5 up to 13 for C6.
+#define SONG_END 0xFF
+
+extern const unsigned char code main_song[];
+extern const unsigned char code draw_song[];
+extern const unsigned char code win_song[];
+
+// Sets up the speaker (tone.h), quiet. EA must be set afterwards.
+void audio_init();
+// Start playing a song, replacing whatever is playing.
+void audio_play(const unsigned char code* song);
+// 1 while a song is playing.
+unsigned char audio_busy();
+// Task that steps through the song.
+char audio_task();
+
+#endif // _AUDIOH_
@@ -0,0 +1,21 @@
+#ifndef _COMPILERH_
+#define _COMPILERH_
+
+// The portable parts of the firmware (rules, protocol) are also built by
+// an ordinary compiler for the host tools in host/. Keil C51 defines
+// __C51__; anywhere else its memory classes mean nothing and go away.
+//
+// Memory classes used in the firmware:
+//   data  - directly addressed RAM (0x00-0x7F), fastest, for hot variables
+//   idata - indirectly addressed RAM (up to 0xFF), for state touched rarely
+//   xdata - the 512 bytes of on-chip XRAM, for buffers
+//   code  - flash, for every constant table and string
+
+#ifndef __C51__
+#define code
+#define data
+#define idata
+#define xdata
+#endif
+
+#endif // _COMPILERH_
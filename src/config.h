@@ -0,0 +1,60 @@
+#ifndef _CONFIGH_
+#define _CONFIGH_
+
+// Build-time options for the game firmware.
+
+// Output modes
+// OUTPUT_ANSI draws the whole board as text art for a plain terminal.
+// OUTPUT_BINARY sends small checksummed state frames (see proto.h) for
+// the host renderer in host/c4view.cpp.
+#define OUTPUT_ANSI   0
+#define OUTPUT_BINARY 1
+
+#ifndef OUTPUT_MODE
+#define OUTPUT_MODE OUTPUT_ANSI
+#endif
+
+// Board-to-board play over I2C (link.c), off unless asked for. Both
+// boards need the same firmware. SDA is P1.3, the pin the win LED sits
+// on, so with the link built in the win LED stays dark.
+#ifndef LINK_ENABLE
+#define LINK_ENABLE 0
+#endif
+
+// Flight recorder (trace.h): the last TRACE_SIZE events, four bytes each
+// of XRAM, dumped by the 'T' serial command. At most 64.
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+#define TRACE_SIZE 32
+
+// Games hosted for remote players over the serial port (session.h), each
+// 32 bytes of XRAM.
+#ifndef SESSION_ENABLE
+#define SESSION_ENABLE 1
+#endif
+#define SESSION_COUNT 6
+
+// UART self-test (the 'U' and 'L' serial commands, console.h): the pattern
+// or the echo for UART_TEST_MS at one of the UART_BAUDS rates, then a
+// report of what got through and how long the UART interrupt took.
+// UART_SETTLE_MS is left after each switch of rate for the host to follow.
+#ifndef UART_TEST_ENABLE
+#define UART_TEST_ENABLE 1
+#endif
+#define UART_TEST_MS   1000
+#define UART_SETTLE_MS 500
+
+// Board geometries the players can choose from, as G(width, height).
+// Button n picks the n-th entry, so there can be at most nine. Widths run
+// from 4 up to the nine column buttons, heights from 4 to 8 (a column is
+// one byte, see rules.h). The rules for each entry are generated at
+// compile time, so every extra geometry costs code space.
+#define GEOMETRIES(G) \
+	G(5, 4) \
+	G(6, 5) \
+	G(7, 6) \
+	G(8, 7) \
+	G(9, 8)
+
+#endif // _CONFIGH_
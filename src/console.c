@@ -0,0 +1,129 @@
+#include "compiler.h"
+#include "config.h"
+#include "pt.h"
+#include "uart.h"
+#include "tick.h"
+#include "proto.h"
+#include "rules.h"
+#include "render.h"
+#include "session.h"
+#include "game.h"
+#include "console.h"
+
+// Longest command frame payload, and how long the bytes of a frame may be
+// apart before it is given up on.
+#define CMD_MAX_PAYLOAD 2
+#define CMD_GAP_MS      100
+
+static struct pt idata console_pt;
+
+/*
+    Desc: Nothing received yet.
+    @params: none
+**/
+void console_init()
+{
+	PT_INIT(&console_pt);
+}
+
+/*
+    Desc: Takes the received bytes one at a time. A command that has output
+          waits its turn for the render task, like the game does.
+    @params: none
+**/
+char console_task()
+{
+	static unsigned char idata command;
+#if UART_TEST_ENABLE || SESSION_ENABLE
+	static unsigned int idata last;
+#endif
+#if UART_TEST_ENABLE
+	static unsigned char idata rate;
+#endif
+#if SESSION_ENABLE
+	static unsigned char idata frame[PROTO_HEADER + CMD_MAX_PAYLOAD + 1];
+	static unsigned char idata i;
+	static unsigned char idata n;
+	static unsigned char idata crc;
+	static unsigned char idata state;
+#endif
+
+	PT_BEGIN(&console_pt);
+
+	while (1)
+	{
+		PT_WAIT_UNTIL(&console_pt, uart_received());
+		command = uart_get();
+
+#if TRACE_ENABLE
+		if (command == 'T')
+		{
+			PT_WAIT_UNTIL(&console_pt, render_idle());
+			render_trace();
+		}
+#endif
+
+		if (command == 'H')
+		{
+			game_hints();
+		}
+
+#if UART_TEST_ENABLE
+		if (command == 'U' || command == 'L')
+		{
+			// then the rate, a digit
+			last = tick_now();
+			PT_WAIT_UNTIL(&console_pt, uart_received() || tick_since(last) > CMD_GAP_MS);
+			if (!uart_received()) continue;
+			rate = uart_get() - '0';
+			if (rate >= UART_BAUD_COUNT) continue;
+
+			PT_WAIT_UNTIL(&console_pt, render_idle());
+			render_uart(rate, command == 'L');
+			// the echo is the test's to read
+			PT_WAIT_UNTIL(&console_pt, render_idle());
+		}
+#endif
+
+#if SESSION_ENABLE
+		if (command == PROTO_SYNC)
+		{
+			// the header, then once the length is in the payload and CRC
+			frame[0] = command;
+			i = 1;
+			n = PROTO_HEADER;
+			last = tick_now();
+			while (i < n)
+			{
+				PT_WAIT_UNTIL(&console_pt, uart_received() || tick_since(last) > CMD_GAP_MS);
+				if (!uart_received()) break;
+				frame[i++] = uart_get();
+				last = tick_now();
+				if (i == PROTO_HEADER)
+				{
+					n = (frame[2] <= CMD_MAX_PAYLOAD ? PROTO_HEADER + frame[2] + 1 : 0);
+				}
+			}
+			if (i != n) continue;
+
+			crc = 0;
+			for (i = 1; i < n - 1; i++)
+			{
+				crc = proto_crc(crc, frame[i]);
+			}
+			if (crc != frame[n - 1]) continue;
+
+			session_row = NO_ROW;
+			if (frame[1] == CMD_OPEN && frame[2] == 2) state = session_open(frame[3], frame[4]);
+			else if (frame[1] == CMD_MOVE && frame[2] == 2) state = session_move(frame[3], frame[4]);
+			else if (frame[1] == CMD_CLOSE && frame[2] == 1) state = session_close(frame[3]);
+			else state = SESSION_REFUSED;
+
+			PT_WAIT_UNTIL(&console_pt, render_idle());
+			render_session(frame[3], state, (frame[1] == CMD_MOVE ? frame[4] : NO_ROW), session_row, session_side(frame[3]));
+		}
+#endif
+	}
+
+	PT_END(&console_pt);
+}
@@ -0,0 +1,25 @@
+#ifndef _CONSOLEH_
+#define _CONSOLEH_
+
+// Commands sent to the board over the serial port, a letter each, some
+// with a digit after.
+// Anything it does not know is ignored.
+//
+//   T  - dump the flight recorder (trace.h)
+//   H  - column hints on or off: from the next turn the LEDs show the
+//        columns where either side would win at once (threat.h), or
+//        when there are none the best scored ones (ponder.h), instead
+//        of whose turn it is
+//   Un - UART self-test at rate n of UART_BAUDS (uart.h), streaming a
+//        counting pattern, then a report line at the usual rate
+//   Ln - the same, echoing everything received instead
+//
+// A PROTO_SYNC byte starts a command frame instead (CMD_ in proto.h),
+// which plays in one of the remote sessions (session.h) and is answered
+// with a MSG_SESSION frame.
+
+void console_init();
+// Task that reads and carries out commands.
+char console_task();
+
+#endif // _CONSOLEH_
@@ -0,0 +1,17 @@
+#include "compiler.h"
+#include "rules.h"
+#include "evaltab.h"
+#include "eval.h"
+
+/*
+    Desc: Look up the value of a piece in a cell. The table only holds the
+          left half of the board and the centre column, the right half is
+          its mirror image.
+    @params: char col, char row - The cell, row 0 at the bottom.
+             char player - SPACE_X or SPACE_O.
+**/
+signed char eval_cell(unsigned char col, unsigned char row, unsigned char player)
+{
+	if (col >= width - col) col = width - 1 - col;
+	return eval_cells[player == SPACE_O][eval_start[geometry] + col * height + row];
+}
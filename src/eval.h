@@ -0,0 +1,18 @@
+#ifndef _EVALH_
+#define _EVALH_
+
+#include "compiler.h"
+#include "rules.h"
+
+// Static evaluation from a learned table (evaltab.c, written by
+// host/train). Every cell of every geometry has a value for an X and one
+// for an O in it, in signed bytes no bigger than EVAL_MAX either way. A
+// move is scored by the value of the cell it lands in, one table read.
+// ponder.c scores every column with it, and the hints (game.c) light the
+// best.
+
+// What a piece of player's (SPACE_X or SPACE_O) is worth in a cell of the
+// geometry in use.
+signed char eval_cell(unsigned char col, unsigned char row, unsigned char player);
+
+#endif // _EVALH_
@@ -0,0 +1,69 @@
+// Generated by host/train, do not edit.
+// Seed 1, 8 rounds of 4000 games for each geometry.
+
+#include "compiler.h"
+#include "rules.h"
+#include "evaltab.h"
+
+const unsigned char code eval_start[GEOM_COUNT] =
+{
+	0, 12, 27, 51, 79
+};
+
+const signed char code eval_cells[2][EVAL_CELLS] =
+{
+	// X
+	{
+		// 5x4
+		-42, -44, 0, 0,
+		-33, 4, 37, 4,
+		-21, 30, 10, -29,
+		// 6x5
+		-35, -7, -31, -4, 13,
+		-15, 15, 39, 35, 13,
+		29, 57, 99, 47, 9,
+		// 7x6
+		-30, -19, 10, -13, -16, 11,
+		-43, -1, 9, 19, 2, -11,
+		19, 9, 40, 34, 19, 1,
+		44, 78, 71, 69, 43, 4,
+		// 8x7
+		-9, -7, 8, 8, -4, -6, 2,
+		-2, -14, 49, 1, -6, 5, 1,
+		-7, 35, 49, 54, 36, 8, -26,
+		31, 62, 77, 76, 61, 28, -6,
+		// 9x8
+		-42, -27, -59, 2, -39, -41, -21, 7,
+		-24, -12, 1, 24, -9, -28, 5, -39,
+		-15, 29, 42, 34, 31, 21, -28, -67,
+		21, 55, 74, 75, 51, -14, -2, -9,
+		4, 33, 99, 45, 0, 41, -38, -16
+	},
+	// O
+	{
+		// 5x4
+		-29, -26, -99, 0,
+		9, -27, 55, 10,
+		-62, 56, 20, 2,
+		// 6x5
+		-20, -12, 1, -3, 4,
+		6, 1, 36, 22, -9,
+		-27, 78, 82, 64, 11,
+		// 7x6
+		-34, -9, -25, 24, -15, 14,
+		11, 16, 22, 5, 8, 7,
+		-36, 46, 35, 44, 25, -30,
+		-36, 47, 99, 54, 38, 6,
+		// 8x7
+		-22, -12, -12, 21, 32, -48, 15,
+		-25, 28, 9, 36, 4, 5, -25,
+		4, 24, 68, 74, 34, 9, -16,
+		-1, 42, 93, 99, 34, 29, -12,
+		// 9x8
+		-63, -50, -12, -61, -27, -24, -95, -4,
+		-31, 6, 6, 18, -11, 4, -16, 44,
+		-10, 26, 31, 33, 41, 6, -31, -36,
+		-2, 54, 86, 56, 57, 39, -7, -46,
+		37, 52, 54, 89, 47, 10, -15, -10
+	}
+};
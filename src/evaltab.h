@@ -0,0 +1,20 @@
+#ifndef _EVALTABH_
+#define _EVALTABH_
+
+// Generated by host/train, do not edit.
+
+#include "compiler.h"
+#include "rules.h"
+
+// No entry is bigger than this either way.
+#define EVAL_MAX 99
+
+// For each geometry the cells of the left half of the board and the
+// centre column, column by column from the bottom, starting at
+// eval_start[geometry]. The first table is X's, the second O's.
+#define EVAL_CELLS 119
+
+extern const unsigned char code eval_start[GEOM_COUNT];
+extern const signed char code eval_cells[2][EVAL_CELLS];
+
+#endif // _EVALTABH_
@@ -0,0 +1,250 @@
+#include "compiler.h"
+#include "config.h"
+#include "rules.h"
+#include "pt.h"
+#include "io.h"
+#include "audio.h"
+#include "render.h"
+#include "ponder.h"
+#include "threat.h"
+#include "trace.h"
+#if LINK_ENABLE
+#include "link.h"
+#endif
+#include "game.h"
+
+static struct pt idata game_pt;
+// Show the columns worth playing instead of whose turn it is, toggled by
+// the 'H' serial command.
+static unsigned char idata hints;
+
+/*
+    Desc: Starts with the size prompt.
+    @params: none
+**/
+void game_init()
+{
+	hints = 0;
+	PT_INIT(&game_pt);
+}
+
+/*
+    Desc: Turn the column hints on or off, from the next turn on.
+    @params: none
+**/
+void game_hints()
+{
+	hints = !hints;
+}
+
+/*
+    Desc: Lights whose turn it is or, with hints on, the columns to look
+          at: any where either side wins at once, otherwise the ones the
+          analysis scores best (ponder.h), unless every move loses.
+    @params: char player - The side to move.
+**/
+static void show_turn(unsigned char player)
+{
+	unsigned int cols;
+	signed char best;
+	unsigned char i;
+
+	cols = threat_x | threat_o;
+	if (hints && !cols && ponder_ready())
+	{
+		best = PONDER_LOSS;
+		for (i = 0; i < width; i++)
+		{
+			if (ponder_score[i] > best)
+			{
+				best = ponder_score[i];
+				cols = 1 << i;
+			}
+			else if (ponder_score[i] == best && cols)
+			{
+				cols |= 1 << i;
+			}
+		}
+	}
+
+	if (hints && cols) led_columns(cols);
+	else led_control(player);
+}
+
+/*
+    Desc: The game as a state machine. Every wait hands the CPU back to the
+          main loop until the button, the screen or the tune is ready.
+    @params: none
+**/
+char game_task()
+{
+	static unsigned char idata current_player;
+	static unsigned char idata col;
+	static unsigned char idata row;
+	static unsigned char idata won;
+#if LINK_ENABLE
+	// Side played on this board when linked to another, SPACE_EMPTY when
+	// both players share this board.
+	static unsigned char idata local_side;
+#endif
+
+	PT_BEGIN(&game_pt);
+
+	// Play the main tune.
+	audio_play(main_song);
+
+	// Have user select size (difficulty), button n picks the n-th of the GEOMETRIES
+	render_select();
+	led_control(CTRL_SIZE);
+#if LINK_ENABLE
+	local_side = SPACE_EMPTY;
+	// or let the other board pick it, whoever picks plays X
+	while (1)
+	{
+		PT_WAIT_UNTIL(&game_pt, (col = input_get()) < GEOM_COUNT || link_peek() == LINK_SYNC);
+		if (col < GEOM_COUNT) break;
+		if (link_a < GEOM_COUNT && (link_b == SPACE_X || link_b == SPACE_O)) break;
+		// a geometry or side this board does not know, not a sync
+		link_take();
+	}
+	if (col >= GEOM_COUNT)
+	{
+		col = link_a;
+		local_side = (link_b == SPACE_X ? SPACE_O : SPACE_X);
+		link_take();
+	}
+	else
+	{
+		link_send(LINK_SYNC, col, SPACE_X);
+		PT_WAIT_UNTIL(&game_pt, !link_busy());
+		// nobody answered, both players stay on this board
+		if (!link_failed()) local_side = SPACE_X;
+	}
+#else
+	PT_WAIT_UNTIL(&game_pt, (col = input_get()) < GEOM_COUNT);
+#endif
+	rules_select(col);
+
+	current_player = SPACE_O; // changed to SPACE_X at start
+
+	while (1)
+	{
+		win_led(0);
+		board_construct();
+		threat_clear();
+		PT_WAIT_UNTIL(&game_pt, render_idle());
+		// whoever did not make the last move, X in the first game
+		render_new_game(current_player == SPACE_X ? SPACE_O : SPACE_X);
+
+		do
+		{
+			// swap players
+			current_player = (current_player == SPACE_X ? SPACE_O : SPACE_X);
+			// think about the position while the player does
+			ponder_start(current_player);
+			// the hints need the scores, which take a few passes of the
+			// main loop, far less than anyone takes to press
+			if (hints) PT_WAIT_UNTIL(&game_pt, ponder_ready());
+			// Changes the simon board to display X or O based on player
+			// turn, or the hints.
+			show_turn(current_player);
+
+			row = NO_ROW;
+#if LINK_ENABLE
+			if (local_side != SPACE_EMPTY && current_player != local_side)
+			{
+				// The other board's turn. If it stops answering or sends a
+				// move that does not fit, finish the game on this board. A sync
+				// here crossed ours on a restart where both boards pressed.
+				do
+				{
+					if (link_peek() == LINK_SYNC) link_take();
+					PT_WAIT_UNTIL(&game_pt, link_peek() != LINK_NONE || link_failed());
+				} while (link_peek() == LINK_SYNC);
+				if (link_peek() == LINK_MOVE)
+				{
+					col = link_a;
+					link_take();
+					TRACE(TRACE_REMOTE, col);
+					row = drop(col, current_player);
+					// presses while waiting do not count
+					input_get();
+				}
+				// a column drop() refused means the boards no longer agree,
+				// the same as no answer
+				if (row == NO_ROW) local_side = SPACE_EMPTY;
+			}
+#endif
+
+			// keep taking presses until one is a column of this board that
+			// still has room (drop() refuses anything else)
+			while (row == NO_ROW)
+			{
+				PT_WAIT_UNTIL(&game_pt, (col = input_get()) != NO_BUTTON);
+				row = drop(col, current_player);
+			}
+			TRACE(TRACE_TAKEN, col);
+			threat_update(col, current_player);
+
+			// The analysis has usually finished while the player was
+			// thinking and already knows whether this move won.
+			won = (ponder_ready() ? ponder_wins(col) : check_win(current_player));
+			TRACE(TRACE_CHECKED, (won != 0) | ponder_ready() << 1);
+			ponder_stop();
+
+#if LINK_ENABLE
+			if (current_player == local_side)
+			{
+				// queued once the last message is acknowledged
+				PT_WAIT_UNTIL(&game_pt, link_send(LINK_MOVE, col, 0));
+			}
+#endif
+
+			render_move(current_player);
+			// If no one has won or if there is no draw keep on making turns.
+		} while (!won && (draw() == 0));
+
+		PT_WAIT_UNTIL(&game_pt, render_idle());
+
+		// If neither player wins
+		if (draw() == 1)
+		{
+			// Plays a sad tune for both players as they lost.
+			audio_play(draw_song);
+			render_result(SPACE_EMPTY);
+		}
+		else
+		{
+			// dododo you win! Play a happy tune for the winner.
+			audio_play(win_song);
+			render_result(current_player);
+			win_led(1);
+		}
+
+#if LINK_ENABLE
+		if (local_side != SPACE_EMPTY)
+		{
+			PT_WAIT_UNTIL(&game_pt, render_idle());
+			render_link();
+		}
+#endif
+
+		// wait for user to press to restart, presses from before the
+		// end of the game do not count
+		input_get();
+#if LINK_ENABLE
+		// a press on either board restarts both
+		PT_WAIT_UNTIL(&game_pt, input_get() != NO_BUTTON || link_peek() == LINK_SYNC);
+		if (local_side != SPACE_EMPTY && link_peek() != LINK_SYNC)
+		{
+			PT_WAIT_UNTIL(&game_pt, link_send(LINK_SYNC, geometry, local_side));
+		}
+		// also drops the other board's sync when both pressed at once
+		link_take();
+#else
+		PT_WAIT_UNTIL(&game_pt, input_get() != NO_BUTTON);
+#endif
+	}
+
+	PT_END(&game_pt);
+}
@@ -0,0 +1,14 @@
+#ifndef _GAMEH_
+#define _GAMEH_
+
+// The game itself: size selection, turns and the end of game, as one
+// task. It only talks to the other tasks through their headers, never to
+// the hardware, so host tools can run it too (host/vboard.cpp).
+
+void game_init();
+// Task that plays the game.
+char game_task();
+// Turn the column hints on the LEDs on or off ('H', console.h).
+void game_hints();
+
+#endif // _GAMEH_
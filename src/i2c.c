@@ -0,0 +1,195 @@
+#include "reg932.h"
+#include "compiler.h"
+#include "config.h"
+#include "i2c.h"
+
+#if LINK_ENABLE
+
+// Bit rate is PCLK / (I2SCLH + I2SCLL), 3.6864 MHz / 37 is just under 100 kHz.
+#define I2C_SCLH 19
+#define I2C_SCLL 18
+
+unsigned char xdata i2c_rx[I2C_MAX_MSG];
+
+static unsigned char xdata tx_buf[I2C_MAX_MSG];
+static unsigned char data tx_len;
+static unsigned char data tx_pos;
+static unsigned char data rx_pos;
+static unsigned char data rx_len;
+static unsigned char data state;
+
+/*
+    Desc: Puts SCL (P1.2) and SDA (P1.3) in open drain mode, sets the bit rate
+          and own address and starts acknowledging it.
+    @params: none
+**/
+void i2c_init()
+{
+	P1M1 |= 0x0C;
+	P1M2 |= 0x0C;
+
+	I2SCLH = I2C_SCLH;
+	I2SCLL = I2C_SCLL;
+	I2ADR = I2C_OWN_ADDR << 1; // no general call
+
+	tx_len = 0;
+	rx_len = 0;
+	state = I2C_IDLE;
+
+	I2CON = 0x44; // I2EN and AA, bit rate from I2SCLH/I2SCLL
+	// priority 0 like the uart, see i2c_isr
+	IP1 &= 0xFE;
+	IP1H &= 0xFE;
+	EI2C = 1;
+}
+
+/*
+    Desc: I2C state change. Master transmitter states send tx_buf, slave
+          receiver states fill i2c_rx; anything else ends the transfer.
+          Shares register bank 1 with uart_isr, which is safe only while
+          the two have the same priority so neither interrupts the other.
+    @params: none
+**/
+void i2c_isr(void) interrupt 6 using 1
+{
+	switch (I2STAT)
+	{
+		// START or repeated START sent, address the other board for writing
+		case 0x08:
+		case 0x10:
+		I2DAT = I2C_OWN_ADDR << 1;
+		STA = 0;
+		tx_pos = 0;
+		break;
+
+		// address or data acknowledged, next byte or STOP
+		case 0x18:
+		case 0x28:
+		if (tx_pos < tx_len)
+		{
+			I2DAT = tx_buf[tx_pos++];
+		}
+		else
+		{
+			STO = 1;
+			state = I2C_DONE;
+		}
+		break;
+
+		// address or data not acknowledged
+		case 0x20:
+		case 0x30:
+		STO = 1;
+		state = I2C_FAILED;
+		break;
+
+		// lost arbitration, release the bus and let the link retry
+		case 0x38:
+		STA = 0;
+		state = I2C_FAILED;
+		break;
+
+		// addressed as slave after losing arbitration as master
+		case 0x68:
+		STA = 0;
+		state = I2C_FAILED;
+		// fall through
+		case 0x60:
+		rx_pos = 0;
+		break;
+
+		// data received
+		case 0x80:
+		case 0x88:
+		if (rx_pos < I2C_MAX_MSG) i2c_rx[rx_pos++] = I2DAT;
+		break;
+
+		// STOP, hold the message and refuse more until it is released
+		case 0xA0:
+		if (rx_pos)
+		{
+			rx_len = rx_pos;
+			AA = 0;
+		}
+		break;
+
+		// bus error
+		case 0x00:
+		STO = 1;
+		state = I2C_FAILED;
+		break;
+
+		default: break;
+	}
+
+	SI = 0;
+}
+
+/*
+    Desc: Start sending a message to the other board.
+    @params: char* msg - The bytes to send.
+             char length - How many, at most I2C_MAX_MSG.
+    Returns 1 if the transfer started, 0 if the last one is not over yet.
+**/
+unsigned char i2c_send(unsigned char xdata* msg, unsigned char length)
+{
+	unsigned char i;
+
+	if (state == I2C_BUSY) return 0;
+
+	for (i = 0; i < length; i++)
+	{
+		tx_buf[i] = msg[i];
+	}
+	tx_len = length;
+	state = I2C_BUSY;
+	STA = 1;
+	return 1;
+}
+
+/*
+    Desc: How the last i2c_send() went.
+    @params: none
+**/
+unsigned char i2c_status()
+{
+	return state;
+}
+
+/*
+    Desc: Whether a message is waiting in i2c_rx.
+    @params: none
+    Returns its length, 0 if there is none.
+**/
+unsigned char i2c_received()
+{
+	return rx_len;
+}
+
+/*
+    Desc: Drop the received message and acknowledge our address again.
+    @params: none
+**/
+void i2c_release()
+{
+	rx_len = 0;
+	AA = 1;
+}
+
+/*
+    Desc: Ends a transfer that hangs, say when the other board reset half
+          way through or a line is held low. Turning the interface off lets
+          go of the bus and forgets the state; a message still held stays
+          refused.
+    @params: none
+**/
+void i2c_abort()
+{
+	EI2C = 0;
+	I2CON = 0x00;
+	state = I2C_FAILED;
+	I2CON = (rx_len ? 0x40 : 0x44);
+	EI2C = 1;
+}
+
+#endif
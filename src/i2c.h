@@ -0,0 +1,38 @@
+#ifndef _I2CH_
+#define _I2CH_
+
+#include "compiler.h"
+
+// Interrupt driven I2C for the link between two boards. Every board is a
+// slave at I2C_OWN_ADDR and becomes master to send, so both boards run the
+// same firmware: a master never answers its own address, the other board
+// does. One message goes out at a time and one received message is held
+// until it is released; while it is held further messages are refused
+// (not acknowledged), so the sender tries again later.
+
+#define I2C_OWN_ADDR 0x30 // 7 bit address of every board
+#define I2C_MAX_MSG  8
+
+// Outcome of the last i2c_send()
+#define I2C_IDLE   0
+#define I2C_BUSY   1
+#define I2C_DONE   2
+#define I2C_FAILED 3 // not acknowledged, arbitration lost or bus error
+
+// The message received, valid while i2c_received() is nonzero.
+extern unsigned char xdata i2c_rx[I2C_MAX_MSG];
+
+// Sets the pins up and enables the I2C interrupt. EA must be set afterwards.
+void i2c_init();
+// Start sending a message to the other board. Returns 0 if one is still going out.
+unsigned char i2c_send(unsigned char xdata* msg, unsigned char length);
+// One of the I2C_ states for the last i2c_send().
+unsigned char i2c_status();
+// Length of the message waiting in i2c_rx, 0 if none.
+unsigned char i2c_received();
+// Done with i2c_rx, accept the next message.
+void i2c_release();
+// Give up on a transfer that never finished, leaving I2C_FAILED.
+void i2c_abort();
+
+#endif // _I2CH_
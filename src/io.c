@@ -0,0 +1,207 @@
+#include "reg932.h"
+#include "compiler.h"
+#include "config.h"
+#include "io.h"
+#include "tick.h"
+#include "trace.h"
+
+sbit led0 = P2^4;
+sbit led1 = P0^5;
+sbit led2 = P2^7;
+sbit led3 = P0^6;
+sbit led4 = P1^6;
+sbit led5 = P0^4;
+sbit led6 = P2^5;
+sbit led7 = P0^7;
+sbit led8 = P2^6;
+
+sbit btn0 = P2^0;
+sbit btn1 = P0^1;
+sbit btn2 = P2^3;
+sbit btn3 = P0^2;
+sbit btn4 = P1^4;
+sbit btn5 = P0^0;
+sbit btn6 = P2^1;
+sbit btn7 = P0^3;
+sbit btn8 = P2^2;
+
+#if !LINK_ENABLE
+// Light upt his LED when someone wins. P1.3 is also SDA, the link needs it.
+sbit o_led = P1^3;
+#endif
+
+static struct pt idata input_pt;
+// Debounced button, and the press not yet collected by input_get().
+static unsigned char data input_held = NO_BUTTON;
+static unsigned char data input_pressed = NO_BUTTON;
+
+/*
+    Desc: Sets the pins to bidirectional and turns the LEDs off.
+    @params: none
+**/
+void io_init()
+{
+	// set pins to bidirectional
+	P0M1 = 0;
+	P0M2 = 0;
+	P1M1 = 0;
+	P1M2 = 0;
+	P2M1 = 0;
+	P2M2 = 0;
+
+	led_control(0);
+	win_led(0);
+	PT_INIT(&input_pt);
+}
+
+/*
+    Desc: Clear all LED's and then lights up either an X or O based on player.
+    @params: char ctrl - Dictates what to display, either player or main selection LEDs.
+**/
+void led_control(unsigned char ctrl)
+{
+	// clear LEDs
+	led0 = 1;
+	led1 = 1;
+	led2 = 1;
+	led3 = 1;
+	led4 = 1;
+	led5 = 1;
+	led6 = 1;
+	led7 = 1;
+	led8 = 1;
+
+	switch (ctrl)
+	{
+		case 'X': // SPACE_X
+		led0 = 0;
+		led2 = 0;
+		led4 = 0;
+		led6 = 0;
+		led8 = 0;
+		break;
+
+		case 'O': // SPACE_O
+		led0 = 0;
+		led1 = 0;
+		led2 = 0;
+		led3 = 0;
+		led5 = 0;
+		led6 = 0;
+		led7 = 0;
+		led8 = 0;
+		break;
+
+		case 'a': // CTRL_SIZE
+		led2 = 0;
+		led4 = 0;
+		led5 = 0;
+		led6 = 0;
+		led7 = 0;
+		led8 = 0;
+		break;
+
+		default: break;
+	}
+}
+
+/*
+    Desc: Light the LEDs of a set of columns, LED n for column n, and clear
+          the rest.
+    @params: int cols - Bit n set to light LED n.
+**/
+void led_columns(unsigned int cols)
+{
+	led0 = !(cols & 0x001);
+	led1 = !(cols & 0x002);
+	led2 = !(cols & 0x004);
+	led3 = !(cols & 0x008);
+	led4 = !(cols & 0x010);
+	led5 = !(cols & 0x020);
+	led6 = !(cols & 0x040);
+	led7 = !(cols & 0x080);
+	led8 = !(cols & 0x100);
+}
+
+/*
+    Desc: The LED that lights up when someone wins. Active low like the others.
+    @params: char on - 1 to light it, 0 to turn it off.
+**/
+void win_led(unsigned char on)
+{
+#if LINK_ENABLE
+	on = on; // the pin is SDA
+#else
+	o_led = !on;
+#endif
+}
+
+/*
+    Desc: Scan the buttons once.
+    @params: none
+    Returns the number of the first button held down, or NO_BUTTON.
+**/
+unsigned char read_button()
+{
+	if (~btn0) return 0;
+	if (~btn1) return 1;
+	if (~btn2) return 2;
+	if (~btn3) return 3;
+	if (~btn4) return 4;
+	if (~btn5) return 5;
+	if (~btn6) return 6;
+	if (~btn7) return 7;
+	if (~btn8) return 8;
+	return NO_BUTTON;
+}
+
+/*
+    Desc: Scans the buttons every INPUT_SCAN_MS. A reading that holds for two
+          scans in a row is taken as the new button state, and going from no
+          button to a button is a press.
+    @params: none
+**/
+char input_task()
+{
+	static unsigned int idata last_scan;
+	static unsigned char idata last_read;
+	unsigned char now;
+
+	PT_BEGIN(&input_pt);
+
+	last_scan = tick_now();
+	last_read = NO_BUTTON;
+
+	while (1)
+	{
+		PT_WAIT_UNTIL(&input_pt, tick_since(last_scan) >= INPUT_SCAN_MS);
+		last_scan += INPUT_SCAN_MS;
+
+		now = read_button();
+		if (now == last_read && now != input_held)
+		{
+			if (input_held == NO_BUTTON)
+			{
+				input_pressed = now;
+				TRACE(TRACE_PRESS, now);
+			}
+			input_held = now;
+		}
+		last_read = now;
+	}
+
+	PT_END(&input_pt);
+}
+
+/*
+    Desc: Collect the last button press.
+    @params: none
+    Returns the button, or NO_BUTTON if nothing was pressed since last time.
+**/
+unsigned char input_get()
+{
+	unsigned char pressed = input_pressed;
+
+	input_pressed = NO_BUTTON;
+	return pressed;
+}
@@ -0,0 +1,38 @@
+#ifndef _IOH_
+#define _IOH_
+
+#include "pt.h"
+
+// Buttons and LEDs of the Simon 2b board.
+
+#define NUM_LEDS 9
+#define NUM_BTNS 9
+#define NO_BUTTON 0xFF
+
+// led_control() pattern for the size prompt.
+#define CTRL_SIZE 'a'
+
+// Milliseconds between button scans, a reading has to hold for two scans
+// to count.
+#define INPUT_SCAN_MS 5
+
+// Sets bidirectional ports and clears the LEDs
+void io_init();
+
+// Controls which player turn it is. Displays an X or an O
+void led_control(unsigned char ctrl);
+// Lights LED n for every bit n set in cols, for column hints.
+void led_columns(unsigned int cols);
+// Light up the win LED (1) or turn it off (0).
+void win_led(unsigned char on);
+
+// Returns the first button held down, or NO_BUTTON.
+unsigned char read_button();
+
+// Task that scans and debounces the buttons.
+char input_task();
+// The button pressed since the last call, or NO_BUTTON. Each press is
+// reported once, holding a button down does not repeat it.
+unsigned char input_get();
+
+#endif // _IOH_
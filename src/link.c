@@ -0,0 +1,226 @@
+#include "compiler.h"
+#include "config.h"
+#include "proto.h"
+#include "tick.h"
+#include "i2c.h"
+#include "link.h"
+
+#if LINK_ENABLE
+
+unsigned char idata link_a;
+unsigned char idata link_b;
+
+unsigned int idata link_rtt_last;
+unsigned int idata link_rtt_max;
+unsigned int idata link_resends;
+
+// Outgoing message and its retransmission state.
+static unsigned char xdata tx_msg[LINK_MSG_LEN];
+static unsigned char idata tx_seq;
+static unsigned char idata tx_seeded;
+static unsigned char idata tx_waiting;
+static unsigned char idata tx_failed;
+static unsigned char idata tx_tries;
+static unsigned int idata tx_first;
+static unsigned int idata tx_last;
+// When the transfer on the bus, ours or an acknowledgement, started.
+static unsigned int idata xfer_start;
+
+// Acknowledgement still to send.
+static unsigned char xdata ack_msg[LINK_MSG_LEN];
+static unsigned char idata ack_due;
+
+// Message waiting for the game, and the last sequence number taken in.
+static unsigned char idata rx_type;
+static unsigned char idata rx_seq;
+static unsigned char idata rx_any;
+
+/*
+    Desc: Fills in a message and its CRC.
+    @params: char* msg - LINK_MSG_LEN bytes.
+             char type, char seq, char a, char b - The message.
+**/
+static void link_build(unsigned char xdata* msg, unsigned char type, unsigned char seq, unsigned char a, unsigned char b)
+{
+	unsigned char i;
+	unsigned char crc = 0;
+
+	msg[0] = type;
+	msg[1] = seq;
+	msg[2] = a;
+	msg[3] = b;
+	for (i = 0; i < LINK_MSG_LEN - 1; i++)
+	{
+		crc = proto_crc(crc, msg[i]);
+	}
+	msg[LINK_MSG_LEN - 1] = crc;
+}
+
+/*
+    Desc: Nothing sent or received yet.
+    @params: none
+**/
+void link_init()
+{
+	tx_seeded = 0;
+	tx_waiting = 0;
+	tx_failed = 0;
+	ack_due = 0;
+	rx_type = LINK_NONE;
+	rx_any = 0;
+	link_rtt_last = 0;
+	link_rtt_max = 0;
+	link_resends = 0;
+}
+
+/*
+    Desc: Takes in what the other board sent, then sends the acknowledgement
+          it is owed or repeats our own message when it is overdue.
+    @params: none
+**/
+void link_task()
+{
+	unsigned char i;
+	unsigned char crc;
+
+	if (i2c_received())
+	{
+		crc = 0;
+		for (i = 0; i < LINK_MSG_LEN - 1; i++)
+		{
+			crc = proto_crc(crc, i2c_rx[i]);
+		}
+
+		if (i2c_received() != LINK_MSG_LEN || crc != i2c_rx[LINK_MSG_LEN - 1])
+		{
+			// damaged, the sender repeats it when no acknowledgement comes
+		}
+		else if (i2c_rx[0] == LINK_ACK)
+		{
+			if (tx_waiting && i2c_rx[2] == tx_msg[1])
+			{
+				tx_waiting = 0;
+				link_rtt_last = tick_since(tx_first);
+				if (link_rtt_last > link_rtt_max) link_rtt_max = link_rtt_last;
+			}
+		}
+		else if (rx_any && i2c_rx[1] == rx_seq)
+		{
+			// a repeat, our acknowledgement was lost
+			ack_due = 1;
+		}
+		else if (rx_type == LINK_NONE)
+		{
+			rx_type = i2c_rx[0];
+			rx_seq = i2c_rx[1];
+			link_a = i2c_rx[2];
+			link_b = i2c_rx[3];
+			rx_any = 1;
+			ack_due = 1;
+		}
+		// else the game has not taken the last one, no acknowledgement
+		// so it is sent again later
+
+		i2c_release();
+	}
+
+	if (i2c_status() == I2C_BUSY)
+	{
+		// a hung transfer would otherwise keep us from ever giving up; a
+		// message was already counted as tried when it was sent
+		if (tick_since(xfer_start) < LINK_XFER_MS) return;
+		i2c_abort();
+	}
+
+	if (ack_due)
+	{
+		link_build(ack_msg, LINK_ACK, 0, rx_seq, 0);
+		if (i2c_send(ack_msg, LINK_MSG_LEN))
+		{
+			ack_due = 0;
+			xfer_start = tick_now();
+		}
+		return;
+	}
+
+	if (tx_waiting && (tx_tries == 0 || tick_since(tx_last) >= LINK_RETRY_MS))
+	{
+		if (tx_tries == LINK_MAX_TRIES)
+		{
+			tx_waiting = 0;
+			tx_failed = 1;
+			return;
+		}
+
+		if (tx_tries) link_resends++;
+		tx_tries++;
+		tx_last = tick_now();
+		xfer_start = tx_last;
+		i2c_send(tx_msg, LINK_MSG_LEN);
+	}
+}
+
+/*
+    Desc: Queue a message for the other board.
+    @params: char type - LINK_SYNC or LINK_MOVE.
+             char a, char b - Its arguments.
+    Returns 1 if it was queued, 0 if the last message is still going.
+**/
+unsigned char link_send(unsigned char type, unsigned char a, unsigned char b)
+{
+	if (tx_waiting) return 0;
+
+	// Start numbering from the time of the first message, which depends on
+	// when somebody pressed a button, so a board that restarts is unlikely
+	// to reuse the number the other board saw last and be taken for a repeat.
+	if (!tx_seeded)
+	{
+		tx_seq = (unsigned char)tick_now();
+		tx_seeded = 1;
+	}
+	tx_seq++;
+	link_build(tx_msg, type, tx_seq, a, b);
+	tx_waiting = 1;
+	tx_failed = 0;
+	tx_tries = 0;
+	tx_first = tick_now();
+	return 1;
+}
+
+/*
+    Desc: Whether the last message is still waiting for its acknowledgement.
+    @params: none
+**/
+unsigned char link_busy()
+{
+	return tx_waiting;
+}
+
+/*
+    Desc: Whether the last message was given up on.
+    @params: none
+**/
+unsigned char link_failed()
+{
+	return tx_failed;
+}
+
+/*
+    Desc: What the other board sent, link_a and link_b hold the arguments.
+    @params: none
+**/
+unsigned char link_peek()
+{
+	return rx_type;
+}
+
+/*
+    Desc: The game is done with the message from link_peek().
+    @params: none
+**/
+void link_take()
+{
+	rx_type = LINK_NONE;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _LINKH_
+#define _LINKH_
+
+#include "compiler.h"
+
+// Link layer for two boards playing one game over I2C (i2c.h).
+//
+// Every message is LINK_MSG_LEN bytes: type, sequence number, two argument
+// bytes and a CRC-8 (proto_crc) over the rest. Moves and syncs are sent
+// one at a time and repeated every LINK_RETRY_MS until the other board
+// acknowledges them; a repeat the other board already has is acknowledged
+// again but not handed to the game twice. A transfer still going after
+// LINK_XFER_MS is aborted and counts as a failed try.
+//
+// The time from first sending a message to its acknowledgement is kept
+// as the link latency (link_rtt_last, link_rtt_max).
+//
+// Only uses i2c.h, tick.h and proto_crc(), so host/linksim.cpp can run it
+// over a software bus.
+
+#define LINK_NONE 0
+#define LINK_SYNC 1 // a: geometry, b: side the sender plays
+#define LINK_MOVE 2 // a: column
+#define LINK_ACK  3 // a: sequence number acknowledged
+
+#define LINK_MSG_LEN   5
+#define LINK_RETRY_MS  20
+#define LINK_MAX_TRIES 25 // give up after about half a second
+#define LINK_XFER_MS   10 // a transfer takes under a millisecond, abort it after this
+
+// Arguments of the message link_peek() reports.
+extern unsigned char idata link_a;
+extern unsigned char idata link_b;
+
+// Latency and retransmissions since link_init().
+extern unsigned int idata link_rtt_last;
+extern unsigned int idata link_rtt_max;
+extern unsigned int idata link_resends;
+
+void link_init();
+// Receives, acknowledges and retransmits. Call it from the main loop.
+void link_task();
+
+// Send a message. Returns 0 while the last one is not acknowledged yet.
+unsigned char link_send(unsigned char type, unsigned char a, unsigned char b);
+// 1 until the last message is acknowledged or given up on.
+unsigned char link_busy();
+// 1 if the other board never acknowledged the last message.
+unsigned char link_failed();
+
+// Type of the message waiting for the game, LINK_NONE if none.
+unsigned char link_peek();
+// Done with it, the next one can come in.
+void link_take();
+
+#endif // _LINKH_
@@ -0,0 +1,117 @@
+#include "compiler.h"
+#include "rules.h"
+#include "pt.h"
+#include "eval.h"
+#include "ponder.h"
+
+signed char idata ponder_score[MAX_WIDTH];
+
+static struct pt idata ponder_pt;
+// Side to move, SPACE_EMPTY while there is nothing to analyse.
+static unsigned char idata side;
+static unsigned char idata done;
+// Bit n set when dropping in column n wins.
+static unsigned int idata win_cols;
+
+/*
+    Desc: Start analysing the board for a player, dropping any analysis
+          still going.
+    @params: char player - SPACE_X or SPACE_O, the side to move.
+**/
+void ponder_start(unsigned char player)
+{
+	side = player;
+	done = 0;
+	win_cols = 0;
+	PT_INIT(&ponder_pt);
+}
+
+/*
+    Desc: Stop analysing, the board is about to change.
+    @params: none
+**/
+void ponder_stop()
+{
+	side = SPACE_EMPTY;
+	done = 0;
+	// back to the top, also when stopped half way through a column
+	PT_INIT(&ponder_pt);
+}
+
+/*
+    Desc: Whether the analysis of the current board is complete.
+    @params: none
+**/
+unsigned char ponder_ready()
+{
+	return done;
+}
+
+/*
+    Desc: Whether a move wins, from the analysis.
+    @params: char col - The column.
+**/
+unsigned char ponder_wins(unsigned char col)
+{
+	return (win_cols >> col) & 1;
+}
+
+/*
+    Desc: Tries each column for the side to move, and each reply to it for
+          the other side. Every step drops the pieces, checks and takes them
+          back before yielding, so the other tasks never see a board that
+          is not the real one.
+    @params: none
+**/
+char ponder_task()
+{
+	static unsigned char data col;
+	static unsigned char data reply;
+	static unsigned char data other;
+	static unsigned char data won;
+
+	PT_BEGIN(&ponder_pt);
+
+	PT_WAIT_UNTIL(&ponder_pt, side != SPACE_EMPTY);
+	other = (side == SPACE_X ? SPACE_O : SPACE_X);
+
+	for (col = 0; col < width; col++)
+	{
+		if (drop(col, side) == NO_ROW)
+		{
+			ponder_score[col] = PONDER_FULL;
+			continue;
+		}
+		won = check_win(side);
+		undo(col);
+
+		if (won)
+		{
+			win_cols |= 1 << col;
+			ponder_score[col] = PONDER_WIN;
+			continue;
+		}
+		// taken back, so the height is the row it landed in
+		ponder_score[col] = eval_cell(col, heights[col], side);
+		PT_YIELD(&ponder_pt);
+
+		// stop at the first reply that wins for the other side
+		for (reply = 0; reply < width && ponder_score[col] != PONDER_LOSS; reply++)
+		{
+			drop(col, side);
+			if (drop(reply, other) != NO_ROW)
+			{
+				if (check_win(other)) ponder_score[col] = PONDER_LOSS;
+				undo(reply);
+			}
+			undo(col);
+			PT_YIELD(&ponder_pt);
+		}
+	}
+
+	done = 1;
+	// until the next ponder_start()
+	PT_WAIT_UNTIL(&ponder_pt, side == SPACE_EMPTY);
+
+	PT_END(&ponder_pt);
+}
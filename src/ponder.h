@@ -0,0 +1,38 @@
+#ifndef _PONDERH_
+#define _PONDERH_
+
+#include "compiler.h"
+#include "rules.h"
+
+// Analysis of the position while the player to move is still thinking.
+// The game starts it when a turn begins; the task then looks at one
+// move and reply per call of the main loop, putting the board back each
+// time, so it only uses time the CPU would otherwise spend waiting for a
+// button. When the move comes it is usually done already and the game
+// knows at once whether the move wins, without a check_win().
+//
+// For every column of the board:
+//   ponder_score - PONDER_WIN if the move wins, PONDER_LOSS if the
+//                  opponent can win straight after it, PONDER_FULL if the
+//                  column is full, otherwise what the cell it lands in is
+//                  worth to the player (eval.h), at most EVAL_MAX either
+//                  way.
+
+#define PONDER_WIN  100
+#define PONDER_LOSS (-100)
+#define PONDER_FULL (-128)
+
+extern signed char idata ponder_score[MAX_WIDTH];
+
+// Analyse the board as it is now for player (SPACE_X or SPACE_O) to move.
+void ponder_start(unsigned char player);
+// The board is about to change, forget the analysis.
+void ponder_stop();
+// 1 once the scores are complete.
+unsigned char ponder_ready();
+// Whether dropping in col wins, valid once ponder_ready().
+unsigned char ponder_wins(unsigned char col);
+// Task that does the analysis, a move and reply at a time.
+char ponder_task();
+
+#endif // _PONDERH_
@@ -0,0 +1,49 @@
+#include "proto.h"
+
+/*
+    Desc: Adds one byte to a running CRC-8 (polynomial 0x07). Bitwise rather
+          than table driven, a table would cost 256 bytes of code for a
+          handful of bytes per move.
+    @params: char crc - The CRC so far (0 to start).
+             char value - The byte to add.
+**/
+unsigned char proto_crc(unsigned char crc, unsigned char value)
+{
+	unsigned char i;
+
+	crc ^= value;
+	for (i = 0; i < 8; i++)
+	{
+		if (crc & 0x80) crc = (crc << 1) ^ PROTO_CRC_POLY;
+		else crc = crc << 1;
+	}
+	return crc;
+}
+
+/*
+    Desc: Fills in the header and CRC around a payload already in the buffer.
+          The caller sends the bytes when the UART is free, so nothing here
+          waits on it.
+    @params: char* frame - The payload starts at frame[PROTO_HEADER].
+             char type - One of the MSG_ types.
+             char length - Number of payload bytes.
+    Returns the number of bytes to send.
+**/
+unsigned char proto_seal(unsigned char xdata* frame, unsigned char type, unsigned char length)
+{
+	unsigned char i;
+	unsigned char crc;
+
+	frame[0] = PROTO_SYNC;
+	frame[1] = type;
+	frame[2] = length;
+
+	crc = 0;
+	for (i = 1; i < PROTO_HEADER + length; i++)
+	{
+		crc = proto_crc(crc, frame[i]);
+	}
+	frame[i] = crc;
+
+	return i + 1;
+}
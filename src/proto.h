@@ -0,0 +1,67 @@
+#ifndef _PROTOH_
+#define _PROTOH_
+
+#include "compiler.h"
+
+// Binary board-state protocol, used when OUTPUT_MODE is OUTPUT_BINARY,
+// and for the session commands (session.h) in either mode.
+//
+// Every frame on the wire looks like
+//     PROTO_SYNC, type, length, payload[length], crc
+// where crc is a CRC-8 (polynomial 0x07, initial value 0) over type,
+// length and the payload. Anything outside a frame is plain text.
+//
+// This header is shared with the host tools in host/ (through
+// host/firmware.hpp), so keep it to plain defines and prototypes.
+
+#define PROTO_SYNC        0xA5
+#define PROTO_CRC_POLY    0x07
+#define PROTO_MAX_PAYLOAD 8
+#define PROTO_HEADER      3 // sync, type, length
+#define PROTO_MAX_FRAME   (PROTO_HEADER + PROTO_MAX_PAYLOAD + 1)
+
+// Message types
+#define MSG_SELECT   0x01 // waiting for a board size, no payload
+#define MSG_NEW_GAME 0x02 // width, height, side to move first
+#define MSG_MOVE     0x03 // column, row, piece placed, side to move next
+#define MSG_RESULT   0x04 // winner ('X' or 'O'), or ' ' for a draw
+#define MSG_LINK     0x05 // board link latency in ms, last and worst, then
+                          // resends, each two bytes high byte first
+#define MSG_TRACE    0x06 // flight recorder dump (trace.h), up to two
+                          // entries a frame, oldest first, an empty frame
+                          // ends the dump
+#define MSG_SESSION  0x07 // answer to a CMD_: session, SESSION_ state,
+                          // column and row of the piece placed (0xFF
+                          // for none), side to move next or the winner
+
+// Commands to the board, framed the same way. Send one and wait for its
+// MSG_SESSION before the next; a frame with a bad CRC is ignored.
+#define CMD_OPEN     0x11 // session, index into GEOMETRIES
+#define CMD_MOVE     0x12 // session, column
+#define CMD_CLOSE    0x13 // session
+
+// Session states
+#define SESSION_PLAYING 0
+#define SESSION_WON     1
+#define SESSION_DRAW    2
+#define SESSION_CLOSED  3
+#define SESSION_REFUSED 4 // the command was not carried out, nothing changed
+
+/*
+    Desc: Adds one byte to a running CRC-8.
+    @params: char crc - The CRC so far (0 to start).
+             char value - The byte to add.
+**/
+unsigned char proto_crc(unsigned char crc, unsigned char value);
+
+/*
+    Desc: Turns a buffer into a frame ready to send. The payload must already
+          be in place after the header, at frame[PROTO_HEADER].
+    @params: char* frame - At least PROTO_MAX_FRAME bytes.
+             char type - One of the MSG_ types.
+             char length - Number of payload bytes, at most PROTO_MAX_PAYLOAD.
+    Returns the number of bytes to send.
+**/
+unsigned char proto_seal(unsigned char xdata* frame, unsigned char type, unsigned char length);
+
+#endif // _PROTOH_
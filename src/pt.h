@@ -0,0 +1,35 @@
+#ifndef _PTH_
+#define _PTH_
+
+// Protothreads: stackless cooperative tasks.
+//
+// A task is a function that starts with PT_BEGIN and ends with PT_END.
+// When it has to wait, it returns to the main loop and the next call
+// resumes right after the wait. Because the function really returns,
+// local variables are lost across a wait, so anything a task needs after
+// a PT_WAIT_UNTIL or PT_YIELD must be static. Only one wait per line, and
+// no switch statements in a task body, the resume point is a case label.
+
+struct pt
+{
+	unsigned int lc; // line to resume at, 0 to start over
+};
+
+#define PT_WAITING 0
+#define PT_ENDED   1
+
+#define PT_INIT(pt) (pt)->lc = 0
+
+#define PT_BEGIN(pt) switch ((pt)->lc) { case 0:
+
+#define PT_END(pt) } (pt)->lc = 0; return PT_ENDED
+
+// Return to the main loop until cond is true.
+#define PT_WAIT_UNTIL(pt, cond) \
+	do { (pt)->lc = __LINE__; case __LINE__: if (!(cond)) return PT_WAITING; } while (0)
+
+// Give the other tasks one turn.
+#define PT_YIELD(pt) \
+	do { (pt)->lc = __LINE__; return PT_WAITING; case __LINE__:; } while (0)
+
+#endif // _PTH_
@@ -0,0 +1,583 @@
+#include "uart.h"
+#include "compiler.h"
+#include "config.h"
+#include "proto.h"
+#include "rules.h"
+#include "pt.h"
+#include "tick.h"
+#include "link.h"
+#include "trace.h"
+#include "text.h"
+#include "render.h"
+
+#define JOB_NONE     0
+#define JOB_SELECT   1
+#define JOB_NEW_GAME 2
+#define JOB_MOVE     3
+#define JOB_RESULT   4
+#define JOB_LINK     5
+#define JOB_TRACE    6
+#define JOB_SESSION  7
+#define JOB_UART     8
+
+// Send one byte as soon as the UART is free. Only one per line, see pt.h.
+#define PUTC(c) do { PT_WAIT_UNTIL(&render_pt, uart_ready()); uart_transmit(c); } while (0)
+
+// Send a packed message (text.h), unpacking it a byte at a time. Uses c,
+// and only one per line like PUTC.
+#define PUTS(id) do { text_open(id); for (c = text_next(); c; c = text_next()) { PUTC(c); } } while (0)
+
+static struct pt idata render_pt;
+
+// What to show next, and the winner, answer or test that goes with it.
+static unsigned char data job;
+static unsigned char idata job_col;
+static unsigned char idata job_row;
+static unsigned char idata job_player;
+
+// The board changed since it was last shown, the last piece placed, and
+// the board as it is being shown: a copy taken when the drawing starts,
+// with the side to move then, so moves made meanwhile wait for the next
+// drawing instead of tearing this one. In binary mode also the cells the
+// host already knows are taken.
+static unsigned char data dirty;
+static unsigned char idata last_player;
+static unsigned char idata frame_next;
+static unsigned char xdata frame_x[MAX_WIDTH];
+static unsigned char xdata frame_o[MAX_WIDTH];
+#if OUTPUT_MODE == OUTPUT_BINARY
+static unsigned char xdata shown[MAX_WIDTH];
+#endif
+#if SESSION_ENABLE
+static unsigned char idata job_session;
+static unsigned char idata job_state;
+#endif
+
+/*
+    Desc: Nothing to show yet.
+    @params: none
+**/
+void render_init()
+{
+	job = JOB_NONE;
+	dirty = 0;
+	PT_INIT(&render_pt);
+}
+
+/*
+    Desc: Whether the last request has gone out completely, the latest
+          board included.
+    @params: none
+**/
+unsigned char render_idle()
+{
+	return job == JOB_NONE && !dirty;
+}
+
+/*
+    Desc: Ask for the size prompt.
+    @params: none
+**/
+void render_select()
+{
+	job = JOB_SELECT;
+}
+
+/*
+    Desc: Ask for a fresh board. In binary mode this is the board geometry
+          and who moves first, the host renderer draws the empty board
+          itself.
+    @params: char first - The side to move first, SPACE_X or SPACE_O.
+**/
+void render_new_game(unsigned char first)
+{
+	job_player = first;
+	job = JOB_NEW_GAME;
+}
+
+/*
+    Desc: Note that a piece was placed. Unlike the other requests this can
+          come at any time: the board is drawn as it is once the render task
+          is free, so moves made faster than it can be drawn are shown
+          together and the screen is never more than one drawing behind.
+          In binary mode only the changed cells and the side to move go
+          out, a few bytes instead of redrawing the whole board.
+    @params: char player - The piece that was placed.
+**/
+void render_move(unsigned char player)
+{
+	last_player = player;
+	dirty = 1;
+}
+
+/*
+    Desc: Copies the board, and who moves next on it, for the drawing
+          about to start.
+    @params: none
+**/
+static void take_frame()
+{
+	unsigned char i;
+
+	for (i = 0; i < MAX_WIDTH; i++)
+	{
+		frame_x[i] = cols_x[i];
+		frame_o[i] = cols_o[i];
+	}
+	frame_next = (last_player == SPACE_X ? SPACE_O : SPACE_X);
+	dirty = 0;
+}
+
+#if OUTPUT_MODE != OUTPUT_BINARY
+/*
+    Desc: Look up one cell of the board being shown, like cell().
+    @params: char col, char row - The cell, row 0 at the bottom.
+**/
+static unsigned char frame_cell(unsigned char col, unsigned char row)
+{
+	if (frame_x[col] & (1 << row)) return SPACE_X;
+	if (frame_o[col] & (1 << row)) return SPACE_O;
+	return SPACE_EMPTY;
+}
+#endif
+
+/*
+    Desc: Ask for the end of game message.
+    @params: char winner - SPACE_X or SPACE_O, or SPACE_EMPTY for a draw.
+**/
+void render_result(unsigned char winner)
+{
+	job_player = winner;
+	job = JOB_RESULT;
+}
+
+/*
+    Desc: Ask for the link latency and resends.
+    @params: none
+**/
+void render_link()
+{
+	job = JOB_LINK;
+}
+
+/*
+    Desc: Ask for the flight recorder to be dumped. Nothing is recorded while
+          it goes out, and the ring is empty afterwards.
+    @params: none
+**/
+void render_trace()
+{
+	job = JOB_TRACE;
+}
+
+#if UART_TEST_ENABLE
+/*
+    Desc: Ask for the UART self-test. The job holds the UART for the whole
+          test, so nothing else is shown meanwhile.
+    @params: char baud - Index into UART_BAUDS to test at.
+             char loopback - 0 to send the pattern, 1 to echo what comes in.
+**/
+void render_uart(unsigned char baud, unsigned char loopback)
+{
+	job_col = baud;
+	job_row = loopback;
+	job = JOB_UART;
+}
+#endif
+
+#if SESSION_ENABLE
+/*
+    Desc: Ask for the answer to a session command (session.h). It goes out
+          as a MSG_SESSION frame in text mode as well, for the program that
+          sent the command.
+    @params: char session - The session.
+             char state - One of the SESSION_ states.
+             char col, char row - Where the piece landed, NO_ROW for none.
+             char side - The side to move next, or the winner.
+**/
+void render_session(unsigned char session, unsigned char state, unsigned char col, unsigned char row, unsigned char side)
+{
+	job_session = session;
+	job_state = state;
+	job_col = col;
+	job_row = row;
+	job_player = side;
+	job = JOB_SESSION;
+}
+
+/*
+    Desc: Builds the MSG_SESSION frame for render_session().
+    @params: char* frame - At least PROTO_MAX_FRAME bytes.
+    Returns the number of bytes to send.
+**/
+static unsigned char session_frame(unsigned char xdata* frame)
+{
+	frame[PROTO_HEADER] = job_session;
+	frame[PROTO_HEADER + 1] = job_state;
+	frame[PROTO_HEADER + 2] = job_col;
+	frame[PROTO_HEADER + 3] = job_row;
+	frame[PROTO_HEADER + 4] = job_player;
+	return proto_seal(frame, MSG_SESSION, 5);
+}
+#endif
+
+#if OUTPUT_MODE != OUTPUT_BINARY && LINK_ENABLE
+// Text before each of link_rtt_last, link_rtt_max and link_resends.
+static const text_id code link_labels[3] =
+{
+	TXT_LINK_LAST, TXT_LINK_WORST, TXT_LINK_RESEND
+};
+#endif
+
+#if (OUTPUT_MODE != OUTPUT_BINARY && TRACE_ENABLE) || UART_TEST_ENABLE
+static const char code hex_digits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+#endif
+
+/*
+    Desc: Sends whatever was asked for, one byte each time the UART is free,
+          and goes idle when it is done.
+    @params: none
+**/
+char render_task()
+{
+#if OUTPUT_MODE == OUTPUT_BINARY
+	static unsigned char xdata frame[PROTO_MAX_FRAME];
+	static unsigned char data n;
+	static unsigned char data i;
+	static unsigned char data col;
+	static unsigned char idata row;
+#if TRACE_ENABLE
+	static unsigned char idata t;
+#endif
+#else
+	static unsigned char data i;
+	static unsigned char data j;
+	static unsigned char idata length;
+	static unsigned char idata lines;
+	static unsigned char idata top;
+	static unsigned char data c;
+	static text_id data text;
+#if SESSION_ENABLE
+	static unsigned char xdata frame[PROTO_MAX_FRAME];
+	static unsigned char data n;
+#endif
+#if LINK_ENABLE
+	static unsigned char idata digits[5];
+	static unsigned char idata k;
+	static unsigned int idata value;
+#endif
+#endif
+
+#if UART_TEST_ENABLE
+	static unsigned int idata start;
+	static unsigned int idata sent;
+	static unsigned int idata received;
+	static unsigned char idata pattern;
+	static unsigned char xdata report[7 + UART_STATS];
+#endif
+
+	PT_BEGIN(&render_pt);
+
+	while (1)
+	{
+		PT_WAIT_UNTIL(&render_pt, job != JOB_NONE || dirty);
+		// the latest board, unless something else was asked for first
+		if (job == JOB_NONE) job = JOB_MOVE;
+#if OUTPUT_MODE == OUTPUT_BINARY
+		if (job == JOB_MOVE) take_frame();
+#else
+		if (job == JOB_NEW_GAME || job == JOB_MOVE) take_frame();
+#endif
+#if TRACE_ENABLE
+		if (job == JOB_TRACE) trace_hold(1);
+#endif
+		TRACE(TRACE_RENDER, job);
+
+#if UART_TEST_ENABLE
+		if (job == JOB_UART)
+		{
+			// let the last byte out at the old rate and the host follow
+			PT_WAIT_UNTIL(&render_pt, uart_ready());
+			uart_baud(job_col);
+			start = tick_now();
+			PT_WAIT_UNTIL(&render_pt, tick_since(start) >= UART_SETTLE_MS);
+
+			// the counting pattern, or every byte received sent back, as
+			// fast as the main loop gets round to it
+			uart_stats(report + 7); // just to clear the counts
+			sent = 0;
+			received = 0;
+			start = tick_now();
+			while (tick_since(start) < UART_TEST_MS)
+			{
+				if (job_row && !uart_received())
+				{
+					PT_YIELD(&render_pt);
+					continue;
+				}
+				if (job_row)
+				{
+					pattern = uart_get();
+					received++;
+				}
+				else
+				{
+					pattern = sent;
+				}
+				PUTC(pattern);
+				sent++;
+			}
+
+			report[0] = job_col;
+			report[1] = sent >> 8;
+			report[2] = sent;
+			start = tick_since(start);
+			report[3] = start >> 8;
+			report[4] = start;
+			report[5] = received >> 8;
+			report[6] = received;
+			uart_stats(report + 7);
+
+			PT_WAIT_UNTIL(&render_pt, uart_ready());
+			uart_baud(UART_BAUD_DEFAULT);
+			start = tick_now();
+			PT_WAIT_UNTIL(&render_pt, tick_since(start) >= UART_SETTLE_MS);
+			// anything left of the echo is not a command
+			while (uart_received())
+			{
+				uart_get();
+			}
+
+			// "u 04 2D00 03E8 0000 0000 2D01 0004A2C4" in hex: the rate,
+			// bytes sent, ms taken, bytes received, then uart_stats()
+			PUTC('u');
+			for (i = 0; i < sizeof report; i++)
+			{
+				if (i == 0 || ((i & 1) && i < sizeof report - 3)) PUTC(' ');
+				PUTC(hex_digits[report[i] >> 4]);
+				PUTC(hex_digits[report[i] & 0x0F]);
+			}
+			PUTC('\r');
+			PUTC('\n');
+		}
+#endif
+
+#if OUTPUT_MODE == OUTPUT_BINARY
+		n = 0;
+		if (job == JOB_SELECT)
+		{
+			n = proto_seal(frame, MSG_SELECT, 0);
+		}
+		else if (job == JOB_NEW_GAME)
+		{
+			for (col = 0; col < MAX_WIDTH; col++)
+			{
+				shown[col] = 0;
+			}
+			frame[PROTO_HEADER] = width;
+			frame[PROTO_HEADER + 1] = height;
+			frame[PROTO_HEADER + 2] = job_player;
+			n = proto_seal(frame, MSG_NEW_GAME, 3);
+		}
+		else if (job == JOB_MOVE)
+		{
+			// a frame for each cell placed since the host last heard, one
+			// unless moves came faster than they could be sent; column by
+			// column then, bottom up
+			for (col = 0; col < width; col++)
+			{
+				for (row = 0; row < height; row++)
+				{
+					if (((frame_x[col] | frame_o[col]) & ~shown[col]) & (1 << row))
+					{
+						frame[PROTO_HEADER] = col;
+						frame[PROTO_HEADER + 1] = row;
+						frame[PROTO_HEADER + 2] = (frame_x[col] & (1 << row) ? SPACE_X : SPACE_O);
+						frame[PROTO_HEADER + 3] = frame_next;
+						n = proto_seal(frame, MSG_MOVE, 4);
+
+						for (i = 0; i < n; i++)
+						{
+							PUTC(frame[i]);
+						}
+					}
+				}
+				shown[col] = frame_x[col] | frame_o[col];
+			}
+			n = 0;
+		}
+		else if (job == JOB_RESULT)
+		{
+			frame[PROTO_HEADER] = job_player;
+			n = proto_seal(frame, MSG_RESULT, 1);
+		}
+		else if (job == JOB_TRACE)
+		{
+#if TRACE_ENABLE
+			// two entries a frame, the empty frame that ends the dump is
+			// sent below
+			for (t = 0; t < trace_count(); t += 2)
+			{
+				for (i = 0; i < 2 * TRACE_ENTRY && t + i / TRACE_ENTRY < trace_count(); i++)
+				{
+					frame[PROTO_HEADER + i] = trace_byte(t + i / TRACE_ENTRY, i % TRACE_ENTRY);
+				}
+				n = proto_seal(frame, MSG_TRACE, i);
+
+				for (i = 0; i < n; i++)
+				{
+					PUTC(frame[i]);
+				}
+			}
+#endif
+			n = proto_seal(frame, MSG_TRACE, 0);
+		}
+#if SESSION_ENABLE
+		else if (job == JOB_SESSION)
+		{
+			n = session_frame(frame);
+		}
+#endif
+		else if (job == JOB_LINK)
+		{
+#if LINK_ENABLE
+			frame[PROTO_HEADER] = link_rtt_last >> 8;
+			frame[PROTO_HEADER + 1] = link_rtt_last;
+			frame[PROTO_HEADER + 2] = link_rtt_max >> 8;
+			frame[PROTO_HEADER + 3] = link_rtt_max;
+			frame[PROTO_HEADER + 4] = link_resends >> 8;
+			frame[PROTO_HEADER + 5] = link_resends;
+#endif
+			n = proto_seal(frame, MSG_LINK, 6);
+		}
+
+		for (i = 0; i < n; i++)
+		{
+			PUTC(frame[i]);
+		}
+#else
+		if (job == JOB_SELECT || job == JOB_NEW_GAME || job == JOB_MOVE)
+		{
+			// "Clears" the screen to be able to print fresh new board.
+			PUTS(TXT_CLEAR);
+		}
+
+		text = TXT_EMPTY;
+		if (job == JOB_SELECT)
+		{
+			// " 5x4" and so on, straight from the GEOMETRIES table
+			PUTS(TXT_SELECT);
+			for (j = 0; j < GEOM_COUNT; j++)
+			{
+				PUTC(' ');
+				PUTC('0' + geom_width[j]);
+				PUTC('x');
+				PUTC('0' + geom_height[j]);
+			}
+			text = TXT_NEWLINE;
+		}
+		else if (job == JOB_RESULT)
+		{
+			if (job_player == SPACE_EMPTY)
+			{
+				text = TXT_DRAW;
+			}
+			else
+			{
+				// Print the player char.
+				PUTC(job_player);
+				text = TXT_WINS;
+			}
+		}
+		else if (job == JOB_LINK)
+		{
+#if LINK_ENABLE
+			for (k = 0; k < 3; k++)
+			{
+				PUTS(link_labels[k]);
+
+				value = (k == 0 ? link_rtt_last : k == 1 ? link_rtt_max : link_resends);
+				i = 0;
+				do
+				{
+					digits[i++] = '0' + value % 10;
+					value /= 10;
+				} while (value);
+
+				while (i)
+				{
+					PUTC(digits[--i]);
+				}
+			}
+			text = TXT_NEWLINE;
+#endif
+		}
+		else if (job == JOB_TRACE)
+		{
+#if TRACE_ENABLE
+			// a line an entry in hex, "t 1A2B 3F 51", then "t" on its own
+			for (j = 0; j < trace_count(); j++)
+			{
+				PUTC('t');
+				for (i = 0; i < TRACE_ENTRY; i++)
+				{
+					if (i != 1) PUTC(' ');
+					c = trace_byte(j, i);
+					PUTC(hex_digits[c >> 4]);
+					PUTC(hex_digits[c & 0x0F]);
+				}
+
+				PUTC('\r');
+				PUTC('\n');
+			}
+			text = TXT_TRACE_END;
+#endif
+		}
+#if SESSION_ENABLE
+		else if (job == JOB_SESSION)
+		{
+			n = session_frame(frame);
+			for (i = 0; i < n; i++)
+			{
+				PUTC(frame[i]);
+			}
+		}
+#endif
+		else if (job == JOB_NEW_GAME || job == JOB_MOVE)
+		{
+			// Give the board boarders and print the char of the board within the "boxes"
+			length = 2 * width + 1;
+			lines = 2 * height + 1;
+			top = height - 1;
+
+			for (j = 0; j < lines; j++)
+			{
+				for (i = 0; i < length; i++)
+				{
+					if (j%2 == 0) c = (i%2 == 0 ? '+' : '-');
+					else if (i%2 == 0) c = '|';
+					else c = frame_cell(i/2, top - j/2);
+					PUTC(c);
+				}
+
+				PUTC('\r');
+				PUTC('\n');
+			}
+		}
+
+		PUTS(text);
+#endif
+
+		TRACE(TRACE_SHOWN, job);
+#if TRACE_ENABLE
+		if (job == JOB_TRACE)
+		{
+			trace_clear();
+			trace_hold(0);
+		}
+#endif
+		job = JOB_NONE;
+	}
+
+	PT_END(&render_pt);
+}
@@ -0,0 +1,42 @@
+#ifndef _RENDERH_
+#define _RENDERH_
+
+#include "config.h"
+
+// Output task. The game asks for something to be shown and carries on,
+// the render task feeds it to the UART one byte whenever the UART is free,
+// as text art or as binary frames depending on OUTPUT_MODE.
+//
+// Only one request at a time: wait for render_idle() before the next.
+
+void render_init();
+// 1 once everything asked for has gone out.
+unsigned char render_idle();
+
+// The size prompt.
+void render_select();
+// A fresh board, first (SPACE_X or SPACE_O) to move.
+void render_new_game(unsigned char first);
+// A piece was placed, shown with any others placed meanwhile once the
+// render task is free. Can be called while it is busy.
+void render_move(unsigned char player);
+// The game is over, winner is SPACE_X, SPACE_O or SPACE_EMPTY for a draw.
+void render_result(unsigned char winner);
+// How the link to the other board did (link.h).
+void render_link();
+// The flight recorder (trace.h), which is then emptied.
+void render_trace();
+#if UART_TEST_ENABLE
+// The UART self-test at one of the UART_BAUDS (uart.h), sending a pattern
+// or echoing (loopback 1), then its report line.
+void render_uart(unsigned char baud, unsigned char loopback);
+#endif
+#if SESSION_ENABLE
+// The answer to a session command (session.h), always a frame.
+void render_session(unsigned char session, unsigned char state, unsigned char col, unsigned char row, unsigned char side);
+#endif
+
+// Task that does the sending.
+char render_task();
+
+#endif // _RENDERH_
@@ -0,0 +1,161 @@
+#include "rules.h"
+
+// The board is read on every check, so it lives in directly addressed RAM.
+unsigned char data geometry;
+unsigned char data width;
+unsigned char data height;
+
+unsigned char data cols_x[MAX_WIDTH];
+unsigned char data cols_o[MAX_WIDTH];
+unsigned char data heights[MAX_WIDTH];
+
+#define GEOM_WIDTH(w, h) w,
+#define GEOM_HEIGHT(w, h) h,
+const unsigned char code geom_width[GEOM_COUNT] = { GEOMETRIES(GEOM_WIDTH) };
+const unsigned char code geom_height[GEOM_COUNT] = { GEOMETRIES(GEOM_HEIGHT) };
+
+// Refuse to build geometries the board cannot hold.
+#define GEOM_CHECK(w, h) typedef char geom_check_##w##x##h[((w) >= 4 && (w) <= MAX_WIDTH && (h) >= 4 && (h) <= MAX_HEIGHT) ? 1 : -1];
+GEOMETRIES(GEOM_CHECK)
+
+/*
+    The rules for each geometry are expanded from the macros below, so every
+    bound is a constant and every line check is straight-line code. A term
+    for a column the geometry does not have folds away to 0.
+**/
+
+// Keep x only when column n exists in a board W wide.
+#define IF_COL(W, n, x) ((W) > (n) ? (x) : 0)
+
+// Nonzero if column i holds four in a column.
+#define VERT(m, i) (m[i] & (m[i] >> 1) & (m[i] >> 2) & (m[i] >> 3))
+
+// Nonzero if columns i..i+3 hold four in a row, four on the rising
+// diagonal or four on the falling diagonal. Shifting column i+k by k rows
+// lines its diagonal cells up with the row in column i.
+#define ACROSS(m, i) ((m[i] & m[i+1] & m[i+2] & m[i+3]) \
+	| (m[i] & (m[i+1] >> 1) & (m[i+2] >> 2) & (m[i+3] >> 3)) \
+	| (m[i] & (m[i+1] << 1) & (m[i+2] << 2) & (m[i+3] << 3)))
+
+#define WIN_LINES(m, W) ( \
+	IF_COL(W, 0, VERT(m, 0)) | IF_COL(W, 1, VERT(m, 1)) | IF_COL(W, 2, VERT(m, 2)) | \
+	IF_COL(W, 3, VERT(m, 3)) | IF_COL(W, 4, VERT(m, 4)) | IF_COL(W, 5, VERT(m, 5)) | \
+	IF_COL(W, 6, VERT(m, 6)) | IF_COL(W, 7, VERT(m, 7)) | IF_COL(W, 8, VERT(m, 8)) | \
+	IF_COL(W, 3, ACROSS(m, 0)) | IF_COL(W, 4, ACROSS(m, 1)) | IF_COL(W, 5, ACROSS(m, 2)) | \
+	IF_COL(W, 6, ACROSS(m, 3)) | IF_COL(W, 7, ACROSS(m, 4)) | IF_COL(W, 8, ACROSS(m, 5)))
+
+// Nonzero if every column of a W by H board is full.
+#define COL_FULL(W, H, n) ((W) <= (n) || heights[n] == (H))
+#define ALL_FULL(W, H) ( \
+	COL_FULL(W, H, 0) && COL_FULL(W, H, 1) && COL_FULL(W, H, 2) && \
+	COL_FULL(W, H, 3) && COL_FULL(W, H, 4) && COL_FULL(W, H, 5) && \
+	COL_FULL(W, H, 6) && COL_FULL(W, H, 7) && COL_FULL(W, H, 8))
+
+#define WIN_CASE(w, h) case GEOM_##w##x##h: return WIN_LINES(m, w) != 0;
+#define DRAW_CASE(w, h) case GEOM_##w##x##h: return ALL_FULL(w, h);
+
+/*
+    Desc: Switch to one of the GEOMETRIES. Takes effect with the next
+          board_construct().
+    @params: char g - Index into GEOMETRIES.
+**/
+void rules_select(unsigned char g)
+{
+	geometry = g;
+	width = geom_width[g];
+	height = geom_height[g];
+}
+
+/*
+    Desc: Empty the board, all of it so stale pieces from a bigger board
+          never show up in a smaller one.
+    @params: none
+**/
+void board_construct()
+{
+	unsigned char i;
+
+	for (i = 0; i < MAX_WIDTH; i++)
+	{
+		cols_x[i] = 0;
+		cols_o[i] = 0;
+		heights[i] = 0;
+	}
+}
+
+/*
+    Desc: Drop a piece into a column.
+    @params: char col - The column, 0 is the leftmost.
+             char player - SPACE_X or SPACE_O.
+    Returns the row the piece landed in, or NO_ROW if the column is
+    off the board or already full.
+**/
+unsigned char drop(unsigned char col, unsigned char player)
+{
+	unsigned char row;
+
+	if (col >= width || heights[col] >= height) return NO_ROW;
+
+	row = heights[col]++;
+	if (player == SPACE_X) cols_x[col] |= 1 << row;
+	else cols_o[col] |= 1 << row;
+	return row;
+}
+
+/*
+    Desc: Take the top piece back out of a column, whoever's it is.
+    @params: char col - A column with at least one piece in it.
+**/
+void undo(unsigned char col)
+{
+	unsigned char mask = ~(1 << --heights[col]);
+
+	cols_x[col] &= mask;
+	cols_o[col] &= mask;
+}
+
+/*
+    Desc: Look up one cell of the board.
+    @params: char col - The column, 0 is the leftmost.
+             char row - The row, 0 is the bottom.
+**/
+unsigned char cell(unsigned char col, unsigned char row)
+{
+	unsigned char mask = 1 << row;
+
+	if (cols_x[col] & mask) return SPACE_X;
+	if (cols_o[col] & mask) return SPACE_O;
+	return SPACE_EMPTY;
+}
+
+/*
+    Desc: check_win checks if a player has any 4 in a row, across, up or
+          on either diagonal, anywhere on the board.
+    @params: char player - To check the correct character (X/O) and see if 4 in a row.
+**/
+unsigned char check_win(unsigned char player)
+{
+	unsigned char data* m = (player == SPACE_X ? cols_x : cols_o);
+
+	switch (geometry)
+	{
+		GEOMETRIES(WIN_CASE)
+		default: break;
+	}
+	return 0;
+}
+
+/*
+    Desc: Check if there is a draw between players, that is every column
+          is full.
+    @params: none
+**/
+unsigned char draw()
+{
+	switch (geometry)
+	{
+		GEOMETRIES(DRAW_CASE)
+		default: break;
+	}
+	return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef _RULESH_
+#define _RULESH_
+
+#include "compiler.h"
+#include "config.h"
+
+// The board is kept as one byte per column for each player: bit j of
+// cols_x[i] is set when column i, row j (row 0 at the bottom) holds an X.
+// heights[i] is the number of pieces in column i, which is also the row
+// the next piece dropped there lands in.
+
+#define MAX_WIDTH  9
+#define MAX_HEIGHT 8
+
+// Returned by drop() when the piece cannot be placed.
+#define NO_ROW 0xFF
+
+// GEOM_5x4, GEOM_6x5, ... in the order of GEOMETRIES, then GEOM_COUNT.
+#define GEOM_ENUM(w, h) GEOM_##w##x##h,
+enum { GEOMETRIES(GEOM_ENUM) GEOM_COUNT };
+
+// Pieces, as they are drawn.
+#define SPACE_X     'X'
+#define SPACE_O     'O'
+#define SPACE_EMPTY ' '
+
+// Width and height of every GEOMETRIES entry.
+extern const unsigned char code geom_width[GEOM_COUNT];
+extern const unsigned char code geom_height[GEOM_COUNT];
+
+// Geometry in use, set by rules_select().
+extern unsigned char data geometry;
+extern unsigned char data width;
+extern unsigned char data height;
+
+extern unsigned char data cols_x[MAX_WIDTH];
+extern unsigned char data cols_o[MAX_WIDTH];
+extern unsigned char data heights[MAX_WIDTH];
+
+// Pick one of the GEOMETRIES entries for the next games.
+void rules_select(unsigned char g);
+// Empty the board.
+void board_construct();
+// Drop a piece in a column. Returns the row it landed in, or NO_ROW.
+unsigned char drop(unsigned char col, unsigned char player);
+// Take back the last piece dropped in a column.
+void undo(unsigned char col);
+// What is in a cell: SPACE_X, SPACE_O or SPACE_EMPTY.
+unsigned char cell(unsigned char col, unsigned char row);
+// Determine if a player has four in a row.
+unsigned char check_win(unsigned char player);
+unsigned char draw(); // This returns 1 if there is a draw
+
+#endif // _RULESH_
@@ -0,0 +1,148 @@
+#include "compiler.h"
+#include "config.h"
+#include "rules.h"
+#include "proto.h"
+#include "session.h"
+
+#if SESSION_ENABLE
+
+// A board as rules.h keeps it, plus where its game is.
+struct session
+{
+	unsigned char state;
+	unsigned char side;
+	unsigned char geometry;
+	unsigned char width;
+	unsigned char height;
+	unsigned char cols_x[MAX_WIDTH];
+	unsigned char cols_o[MAX_WIDTH];
+	unsigned char heights[MAX_WIDTH];
+};
+
+static struct session xdata sessions[SESSION_COUNT];
+
+unsigned char idata session_row;
+
+/*
+    Desc: Exchanges the rules engine's board with a session's. Done once
+          to play on the session and once more to put everything back.
+    @params: struct session* s - The session.
+**/
+static void session_swap(struct session xdata* s)
+{
+	unsigned char i;
+	unsigned char t;
+
+	t = geometry;
+	geometry = s->geometry;
+	s->geometry = t;
+	t = width;
+	width = s->width;
+	s->width = t;
+	t = height;
+	height = s->height;
+	s->height = t;
+
+	for (i = 0; i < MAX_WIDTH; i++)
+	{
+		t = cols_x[i];
+		cols_x[i] = s->cols_x[i];
+		s->cols_x[i] = t;
+		t = cols_o[i];
+		cols_o[i] = s->cols_o[i];
+		s->cols_o[i] = t;
+		t = heights[i];
+		heights[i] = s->heights[i];
+		s->heights[i] = t;
+	}
+}
+
+/*
+    Desc: Every session closed.
+    @params: none
+**/
+void session_init()
+{
+	unsigned char n;
+
+	for (n = 0; n < SESSION_COUNT; n++)
+	{
+		sessions[n].state = SESSION_CLOSED;
+		sessions[n].side = SPACE_EMPTY;
+	}
+	session_row = NO_ROW;
+}
+
+/*
+    Desc: Starts a game in a session, over whatever was there.
+    @params: char n - The session, below SESSION_COUNT.
+             char g - Index into GEOMETRIES.
+**/
+unsigned char session_open(unsigned char n, unsigned char g)
+{
+	struct session xdata* s;
+
+	if (n >= SESSION_COUNT || g >= GEOM_COUNT) return SESSION_REFUSED;
+	s = &sessions[n];
+
+	session_swap(s);
+	rules_select(g);
+	board_construct();
+	session_swap(s);
+
+	s->state = SESSION_PLAYING;
+	s->side = SPACE_X;
+	return SESSION_PLAYING;
+}
+
+/*
+    Desc: Plays the side to move in a session, and decides the game once
+          the move wins or fills the board.
+    @params: char n - The session, below SESSION_COUNT.
+             char col - The column.
+**/
+unsigned char session_move(unsigned char n, unsigned char col)
+{
+	struct session xdata* s;
+
+	session_row = NO_ROW;
+	if (n >= SESSION_COUNT || sessions[n].state != SESSION_PLAYING) return SESSION_REFUSED;
+	s = &sessions[n];
+
+	session_swap(s);
+	session_row = drop(col, s->side);
+	if (session_row != NO_ROW)
+	{
+		if (check_win(s->side)) s->state = SESSION_WON;
+		else if (draw()) s->state = SESSION_DRAW;
+	}
+	session_swap(s);
+
+	if (session_row == NO_ROW) return SESSION_REFUSED;
+	if (s->state == SESSION_PLAYING) s->side = (s->side == SPACE_X ? SPACE_O : SPACE_X);
+	else if (s->state == SESSION_DRAW) s->side = SPACE_EMPTY;
+	return s->state;
+}
+
+/*
+    Desc: Frees a session for the next open.
+    @params: char n - The session, below SESSION_COUNT.
+**/
+unsigned char session_close(unsigned char n)
+{
+	if (n >= SESSION_COUNT) return SESSION_REFUSED;
+	sessions[n].state = SESSION_CLOSED;
+	sessions[n].side = SPACE_EMPTY;
+	return SESSION_CLOSED;
+}
+
+/*
+    Desc: Who is to move in a session, or who won it.
+    @params: char n - The session, below SESSION_COUNT.
+**/
+unsigned char session_side(unsigned char n)
+{
+	return (n < SESSION_COUNT ? sessions[n].side : SPACE_EMPTY);
+}
+
+#endif
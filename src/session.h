@@ -0,0 +1,38 @@
+#ifndef _SESSIONH_
+#define _SESSIONH_
+
+#include "compiler.h"
+#include "config.h"
+#include "proto.h"
+
+// Games played for remote players, besides the one on the buttons. Each
+// session is a board of its own in XRAM, addressed by its number, and
+// driven by the framed serial commands (CMD_ in proto.h, read by
+// console.c). A command swaps its session's board into the rules engine
+// (rules.h), plays on it and swaps the board on the buttons back before
+// returning, so the game, the render task and the analysis never see a
+// session's board.
+//
+// Every command answers with the session's state, one of the SESSION_
+// codes in proto.h, and the side after it: the side to move while
+// playing, the winner once won.
+
+#if SESSION_ENABLE
+
+void session_init();
+// Start a new game of geometry g in session n, X to move. A session
+// already open starts again.
+unsigned char session_open(unsigned char n, unsigned char g);
+// Drop a piece for the side to move in session n. The row it landed in is
+// left in session_row, NO_ROW when the move was refused.
+unsigned char session_move(unsigned char n, unsigned char col);
+// Finish with session n.
+unsigned char session_close(unsigned char n);
+// The side to move in session n, or the winner.
+unsigned char session_side(unsigned char n);
+
+extern unsigned char idata session_row;
+
+#endif
+
+#endif // _SESSIONH_
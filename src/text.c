@@ -0,0 +1,64 @@
+#include "compiler.h"
+#include "config.h"
+#include "texttab.h"
+#include "text.h"
+
+// Only text output prints messages.
+#if OUTPUT_MODE != OUTPUT_BINARY
+
+// Next byte of the open message in text_data, and when strc packed it
+// (-p) the second halves of the pairs being unpacked, innermost last.
+static const unsigned char code* data text_at;
+#if TXT_MAX_DEPTH
+static unsigned char idata text_stack[TXT_MAX_DEPTH];
+static unsigned char data text_depth;
+#endif
+
+/*
+    Desc: Start reading a message from the beginning.
+    @params: text_id id - One of the TXT_ IDs in texttab.h.
+**/
+void text_open(text_id id)
+{
+	text_at = text_data + id;
+#if TXT_MAX_DEPTH
+	text_depth = 0;
+#endif
+}
+
+/*
+    Desc: Takes the next byte. In packed text a pair code is replaced by its
+          first half, and its second half is kept for later, until what is
+          left is a plain character. Pairs nest at most TXT_MAX_DEPTH deep,
+          so that is all the stack ever holds.
+    @params: none
+    Returns the byte, or 0 at the end of the message (and after it).
+**/
+unsigned char text_next()
+{
+	unsigned char c;
+
+#if TXT_MAX_DEPTH
+	if (text_depth)
+	{
+		c = text_stack[--text_depth];
+	}
+	else
+	{
+		c = *text_at;
+		if (c) text_at++;
+	}
+
+	while (c >= TXT_FIRST_PAIR)
+	{
+		text_stack[text_depth++] = text_pairs[c - TXT_FIRST_PAIR][1];
+		c = text_pairs[c - TXT_FIRST_PAIR][0];
+	}
+#else
+	c = *text_at;
+	if (c) text_at++;
+#endif
+	return c;
+}
+
+#endif
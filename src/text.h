@@ -0,0 +1,17 @@
+#ifndef _TEXTH_
+#define _TEXTH_
+
+#include "compiler.h"
+#include "texttab.h"
+
+// Text messages, in one table in code memory written by host/strc
+// (texttab.h has the IDs). A message is read, and unpacked if strc packed
+// it, one byte at a time as it is sent, so it never needs a buffer: open
+// it, then take bytes until the 0.
+
+// Start reading a message.
+void text_open(text_id id);
+// The next byte of the open message, 0 once it is over.
+unsigned char text_next();
+
+#endif // _TEXTH_
@@ -0,0 +1,30 @@
+// Generated by host/strc from src/messages.txt, do not edit.
+// 10 messages in 193 bytes, 197 bytes one by one.
+
+#include "compiler.h"
+#include "config.h"
+#include "texttab.h"
+
+#if OUTPUT_MODE != OUTPUT_BINARY
+
+const unsigned char code text_data[193] =
+{
+	// TXT_CLEAR
+	0x1B, '[', '2', 'J', 0x1B, '[', 'H', 0,
+	// TXT_SELECT
+	'C', 'h', 'o', 'o', 's', 'e', ' ', 'a', ' ', 's', 'i', 'z', 'e', ',', ' ', 'o', 'n', 'e', ' ', 'b', 'u', 't', 't', 'o', 'n', ' ', 'e', 'a', 'c', 'h', ':', 0,
+	// TXT_EMPTY, TXT_DRAW
+	'T', 'h', 'e', 'r', 'e', ' ', 'w', 'a', 's', ' ', 'a', ' ', 'd', 'r', 'a', 'w', '!', ' ', 'G', 'o', 'o', 'd', ' ', 'l', 'u', 'c', 'k', ' ', 'n', 'e', 'x', 't', ' ', 't', 'i', 'm', 'e', '.', ' ', 'H', 'i', 't', ' ', 'a', 'n', 'y', ' ', 'b', 'u', 't', 't', 'o', 'n', ' ', 't', 'o', ' ', 't', 'r', 'y', ' ', 'a', 'g', 'a', 'i', 'n', '.', 0,
+	// TXT_WINS, TXT_NEWLINE
+	' ', 'w', 'i', 'n', 's', '!', ' ', 'P', 'r', 'e', 's', 's', ' ', 'a', 'n', 'y', ' ', 'b', 'u', 't', 't', 'o', 'n', ' ', 't', 'o', ' ', 'p', 'l', 'a', 'y', ' ', 'a', 'n', 'o', 't', 'h', 'e', 'r', ' ', 'g', 'a', 'm', 'e', '.', 0x0D, 0x0A, 0,
+	// TXT_LINK_LAST
+	'L', 'i', 'n', 'k', ':', ' ', 0,
+	// TXT_LINK_WORST
+	' ', 'm', 's', ',', ' ', 'w', 'o', 'r', 's', 't', ' ', 0,
+	// TXT_LINK_RESEND
+	' ', 'm', 's', ',', ' ', 'r', 'e', 's', 'e', 'n', 'd', 's', ' ', 0,
+	// TXT_TRACE_END
+	't', 0x0D, 0x0A, 0
+};
+
+#endif
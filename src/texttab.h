@@ -0,0 +1,27 @@
+#ifndef _TEXTTABH_
+#define _TEXTTABH_
+
+// Generated by host/strc from src/messages.txt, do not edit.
+
+#include "compiler.h"
+
+#define TXT_EMPTY        107 // ""
+#define TXT_CLEAR        0 // "\033[2J\033[H"
+#define TXT_SELECT       8 // "Choose a size, one button each:"
+#define TXT_DRAW         40 // "There was a draw! Good luck next time. Hit any button to try again."
+#define TXT_WINS         108 // " wins! Press any button to play another game.\r\n"
+#define TXT_NEWLINE      153 // "\r\n"
+#define TXT_LINK_LAST    156 // "Link: "
+#define TXT_LINK_WORST   163 // " ms, worst "
+#define TXT_LINK_RESEND  175 // " ms, resends "
+#define TXT_TRACE_END    189 // "t\r\n"
+
+// A message ID is where the message starts in text_data, it ends at a 0.
+typedef unsigned char text_id;
+
+// Plain text, no pairs to expand.
+#define TXT_MAX_DEPTH  0
+
+extern const unsigned char code text_data[193];
+
+#endif // _TEXTTABH_
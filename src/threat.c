@@ -0,0 +1,110 @@
+#include "compiler.h"
+#include "rules.h"
+#include "threat.h"
+
+unsigned int idata threat_x;
+unsigned int idata threat_o;
+
+// Bit j of mask_x[i] is set when an X in column i, row j would complete
+// four, bits from the board height up always clear.
+static unsigned char xdata mask_x[MAX_WIDTH];
+static unsigned char xdata mask_o[MAX_WIDTH];
+
+/*
+    Desc: Forget every threat, for an empty board.
+    @params: none
+**/
+void threat_clear()
+{
+	unsigned char i;
+
+	for (i = 0; i < MAX_WIDTH; i++)
+	{
+		mask_x[i] = 0;
+		mask_o[i] = 0;
+	}
+	threat_x = 0;
+	threat_o = 0;
+}
+
+/*
+    Desc: Works out the cells of a column where a piece would complete
+          four, from the three below it and from every window of four
+          columns the column is in. Shifting column j by j - c rows lines
+          its diagonal cells up with the rows of column c, as in rules.c.
+    @params: char data* m - The player's columns, cols_x or cols_o.
+             char c - The column.
+**/
+static unsigned char column_mask(unsigned char data* m, unsigned char c)
+{
+	unsigned char t;
+	unsigned char s;
+	unsigned char j;
+	unsigned char across;
+	unsigned char up;
+	unsigned char down;
+
+	t = (m[c] << 1) & (m[c] << 2) & (m[c] << 3);
+
+	for (s = (c < 3 ? 0 : c - 3); s <= c && s + 3 < width; s++)
+	{
+		across = 0xFF;
+		up = 0xFF;
+		down = 0xFF;
+		for (j = s; j < s + 4; j++)
+		{
+			if (j == c) continue;
+			across &= m[j];
+			if (j > c)
+			{
+				up &= m[j] >> (j - c);
+				down &= m[j] << (j - c);
+			}
+			else
+			{
+				up &= m[j] << (c - j);
+				down &= m[j] >> (c - j);
+			}
+		}
+		t |= across | up | down;
+	}
+
+	return t & ((1 << height) - 1);
+}
+
+/*
+    Desc: Whether the next cell of a column is one of the mask's.
+    @params: char c - The column.
+             char mask - Its mask.
+**/
+static unsigned char next_wins(unsigned char c, unsigned char mask)
+{
+	return heights[c] < height && ((mask >> heights[c]) & 1);
+}
+
+/*
+    Desc: Brings the masks and the threat columns up to date after a move,
+          redoing only the columns it can have changed.
+    @params: char col - The column the piece went in.
+             char player - SPACE_X or SPACE_O, who dropped it.
+**/
+void threat_update(unsigned char col, unsigned char player)
+{
+	unsigned char c;
+	unsigned char last;
+
+	last = (col + 3 < width ? col + 3 : width - 1);
+	for (c = (col < 3 ? 0 : col - 3); c <= last; c++)
+	{
+		if (player == SPACE_X) mask_x[c] = column_mask(cols_x, c);
+		else mask_o[c] = column_mask(cols_o, c);
+	}
+
+	for (c = (col < 3 ? 0 : col - 3); c <= last; c++)
+	{
+		if (next_wins(c, mask_x[c])) threat_x |= 1 << c;
+		else threat_x &= ~(1 << c);
+		if (next_wins(c, mask_o[c])) threat_o |= 1 << c;
+		else threat_o &= ~(1 << c);
+	}
+}
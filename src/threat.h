@@ -0,0 +1,28 @@
+#ifndef _THREATH_
+#define _THREATH_
+
+#include "compiler.h"
+#include "rules.h"
+
+// Immediate threats of the game on the buttons: the columns where a piece
+// of either side would make four right now. Each side keeps a mask per
+// column of the cells, free or not, that would complete one of its lines.
+// A move can only add cells to the mover's masks within three columns of
+// it, and can only change which cell of its own column is the next one
+// for either side, so threat_update() redoes those few columns instead of
+// scanning the board, and the answers are then ready without any search.
+//
+// Only real moves are followed: the drop()/undo() pairs of ponder.c and
+// the boards of the remote sessions (session.h) leave the masks alone.
+
+// Columns where a piece of SPACE_X or SPACE_O wins at once, bit n for
+// column n.
+extern unsigned int idata threat_x;
+extern unsigned int idata threat_o;
+
+// The board was emptied.
+void threat_clear();
+// player (SPACE_X or SPACE_O) dropped a piece in col.
+void threat_update(unsigned char col, unsigned char player);
+
+#endif // _THREATH_
@@ -0,0 +1,93 @@
+#include "reg932.h"
+#include "compiler.h"
+#include "tick.h"
+
+static unsigned int data tick_ms;
+
+/*
+    Desc: Sets timer 0 up as a 16 bit timer that interrupts every millisecond.
+    @params: none
+**/
+void tick_init()
+{
+	tick_ms = 0;
+
+	TMOD = (TMOD & 0xF0) | 0x01; // timer 0, mode 1, leave timer 1 alone
+	TH0 = (unsigned char)(TICK_RELOAD >> 8);
+	TL0 = (unsigned char)TICK_RELOAD;
+	TF0 = 0;
+	ET0 = 1;
+	TR0 = 1;
+}
+
+/*
+    Desc: Timer 0 overflow. Reloads for the next millisecond and counts it.
+    @params: none
+**/
+void tick_isr(void) interrupt 1 using 2
+{
+	TR0 = 0;
+	TH0 = (unsigned char)(TICK_RELOAD >> 8);
+	TL0 = (unsigned char)TICK_RELOAD;
+	TR0 = 1;
+	tick_ms++;
+}
+
+/*
+    Desc: Current millisecond count. The count is two bytes, so the tick
+          interrupt is held off while both are read.
+    @params: none
+**/
+unsigned int tick_now()
+{
+	unsigned int now;
+
+	ET0 = 0;
+	now = tick_ms;
+	ET0 = 1;
+	return now;
+}
+
+/*
+    Desc: Milliseconds elapsed since an earlier tick_now(), correct across
+          the wrap as long as it is under 65 seconds.
+    @params: int start - An earlier tick_now().
+**/
+unsigned int tick_since(unsigned int start)
+{
+	return tick_now() - start;
+}
+
+/*
+    Desc: tick_now(), and how far into that millisecond the timer is in
+          steps of TICK_FINE_STEP counts. The timer is read high, low,
+          high again until the two high bytes agree, and an overflow the
+          interrupt has not seen yet counts as the next millisecond.
+    @params: char* fine - Set to the part of the millisecond, 0 to
+                          TICK_FINE_MAX.
+**/
+unsigned int tick_fine(unsigned char data* fine)
+{
+	unsigned int now;
+	unsigned char high;
+	unsigned char low;
+
+	ET0 = 0;
+	do
+	{
+		high = TH0;
+		low = TL0;
+	} while (high != TH0);
+	now = tick_ms;
+	if (TF0)
+	{
+		now++;
+		*fine = 0;
+	}
+	else
+	{
+		*fine = (((unsigned int)high << 8 | low) - (unsigned int)TICK_RELOAD) / TICK_FINE_STEP;
+	}
+	ET0 = 1;
+	return now;
+}
@@ -0,0 +1,28 @@
+#ifndef _TICKH_
+#define _TICKH_
+
+#include "compiler.h"
+
+// System tick: timer 0 interrupts once a millisecond and counts up a
+// 16 bit millisecond clock that wraps about every 65 seconds. Compare
+// times with tick_since(), never directly, so the wrap does not matter.
+
+// Timer 0 reload for 1 ms. The timers run at the peripheral clock,
+// OSC_FREQ / 2 = 3.6864 MHz, so 3686 counts.
+#define TICK_RELOAD (65536UL - 3686UL)
+
+// tick_fine() resolution: 16 timer counts, about 4.3 us, so a millisecond
+// is 0 to TICK_FINE_MAX.
+#define TICK_FINE_STEP 16
+#define TICK_FINE_MAX  (3686 / TICK_FINE_STEP)
+
+// Start timer 0. EA must be set afterwards.
+void tick_init();
+// Milliseconds since tick_init(), wrapping.
+unsigned int tick_now();
+// Milliseconds since an earlier tick_now().
+unsigned int tick_since(unsigned int start);
+// tick_now() to a few microseconds, for timing stages (trace.h).
+unsigned int tick_fine(unsigned char data* fine);
+
+#endif // _TICKH_
@@ -0,0 +1,61 @@
+#include "reg932.h"
+#include "compiler.h"
+#include "tone.h"
+
+// Speaker to play tunes.
+sbit speaker = P1^7;
+
+// Timer 1 reload of the note playing, read by the interrupt.
+static unsigned char data tone_high;
+static unsigned char data tone_low;
+
+/*
+    Desc: Sets timer 1 up as a 16 bit timer for the speaker, stopped.
+    @params: none
+**/
+void tone_init()
+{
+	TMOD = (TMOD & 0x0F) | 0x10; // timer 1, mode 1, leave timer 0 alone
+	TR1 = 0;
+	TF1 = 0;
+	ET1 = 1;
+	speaker = 1;
+}
+
+/*
+    Desc: Timer 1 overflow, half a period of the note is up.
+    @params: none
+**/
+void tone_isr(void) interrupt 3 using 3
+{
+	TR1 = 0;
+	TH1 = tone_high;
+	TL1 = tone_low;
+	TR1 = 1;
+	speaker = !speaker;
+}
+
+/*
+    Desc: Start toggling the speaker at a note's pitch.
+    @params: char high, char low - Timer 1 reload for half a period.
+**/
+void tone_start(unsigned char high, unsigned char low)
+{
+	tone_high = high;
+	tone_low = low;
+	speaker = 0;
+	TH1 = high;
+	TL1 = low;
+	TR1 = 1;
+}
+
+/*
+    Desc: Silence the speaker.
+    @params: none
+**/
+void tone_stop()
+{
+	TR1 = 0;
+	TF1 = 0;
+	speaker = 1;
+}
@@ -0,0 +1,16 @@
+#ifndef _TONEH_
+#define _TONEH_
+
+// The speaker. Timer 1 interrupts every half period of the note and
+// toggles the pin, so a tone sounds without the CPU waiting on it.
+// audio.c decides what to play and for how long.
+
+// Sets up timer 1, stopped. EA must be set afterwards.
+void tone_init();
+// Start a tone. high, low - timer 1 reload for half a period, the
+// peripheral clock counts up from it to the overflow.
+void tone_start(unsigned char high, unsigned char low);
+// Silence the speaker.
+void tone_stop();
+
+#endif // _TONEH_
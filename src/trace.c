@@ -0,0 +1,83 @@
+#include "compiler.h"
+#include "config.h"
+#include "tick.h"
+#include "trace.h"
+
+// The ring, oldest entry at trace_next once it has filled up.
+static unsigned char xdata ring[TRACE_SIZE * TRACE_ENTRY];
+static unsigned char idata trace_next;
+static unsigned char idata trace_used;
+static unsigned char idata trace_held;
+
+/*
+    Desc: Starts with an empty ring, recording.
+    @params: none
+**/
+void trace_init()
+{
+	trace_clear();
+	trace_held = 0;
+}
+
+/*
+    Desc: Stamps an event and puts it in the ring over the oldest one.
+    @params: char event - One of the TRACE_ events.
+             char arg - Its argument, 0 to 15.
+**/
+void trace_event(unsigned char event, unsigned char arg)
+{
+	unsigned char fine;
+	unsigned int now;
+	unsigned char xdata* entry;
+
+	if (trace_held) return;
+
+	now = tick_fine(&fine);
+	entry = ring + trace_next * TRACE_ENTRY;
+	entry[0] = now >> 8;
+	entry[1] = now;
+	entry[2] = fine;
+	entry[3] = event << 4 | (arg & 0x0F);
+
+	trace_next = (trace_next + 1) % TRACE_SIZE;
+	if (trace_used < TRACE_SIZE) trace_used++;
+}
+
+/*
+    Desc: Holds recording off, so the ring does not move under a dump.
+    @params: char hold - 1 to stop recording, 0 to carry on.
+**/
+void trace_hold(unsigned char hold)
+{
+	trace_held = hold;
+}
+
+/*
+    Desc: How many entries there are to read.
+    @params: none
+**/
+unsigned char trace_count()
+{
+	return trace_used;
+}
+
+/*
+    Desc: Reads one byte of an entry, counting from the oldest.
+    @params: char n - Entry, 0 for the oldest, below trace_count().
+             char i - Byte of it, below TRACE_ENTRY.
+**/
+unsigned char trace_byte(unsigned char n, unsigned char i)
+{
+	n = (trace_next + TRACE_SIZE - trace_used + n) % TRACE_SIZE;
+	return ring[n * TRACE_ENTRY + i];
+}
+
+/*
+    Desc: Empties the ring, after a dump each event is sent only once.
+    @params: none
+**/
+void trace_clear()
+{
+	trace_next = 0;
+	trace_used = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef _TRACEH_
+#define _TRACEH_
+
+#include "compiler.h"
+#include "config.h"
+
+// Flight recorder. The tasks note each stage a move goes through, from
+// the button press to the last byte of the board going out, in a ring of
+// the last TRACE_SIZE events in XRAM, each stamped to a few microseconds.
+// The 'T' serial command (console.h) dumps the ring and empties it;
+// host/latency.cpp turns dumps into per-stage latencies.
+//
+// An entry is four bytes: the millisecond (tick_now(), high byte first),
+// the part of that millisecond in steps of TICK_FINE_STEP timer counts,
+// then the event in the high nibble and its argument in the low one.
+
+#define TRACE_PRESS   1 // a button press was debounced, arg the button
+#define TRACE_REMOTE  2 // a move came in from the other board, arg the column
+#define TRACE_TAKEN   3 // the game dropped the piece, arg the column
+#define TRACE_CHECKED 4 // the win check is done, arg bit 0 won, bit 1 ponder knew
+#define TRACE_RENDER  5 // output of a render job started, arg the job
+#define TRACE_SHOWN   6 // its last byte went to the UART, arg the job
+#define TRACE_SONG    7 // a song started
+#define TRACE_QUIET   8 // the song is over
+
+#define TRACE_ENTRY 4
+
+#if TRACE_ENABLE
+#define TRACE(event, arg) trace_event(event, arg)
+#else
+#define TRACE(event, arg)
+#endif
+
+void trace_init();
+// Record an event. Tasks only, not interrupts.
+void trace_event(unsigned char event, unsigned char arg);
+// Stop recording (1) while the ring is being read, or carry on (0).
+void trace_hold(unsigned char hold);
+// Number of entries recorded, at most TRACE_SIZE.
+unsigned char trace_count();
+// Byte i of the n-th oldest entry.
+unsigned char trace_byte(unsigned char n, unsigned char i);
+// Forget everything recorded.
+void trace_clear();
+
+#endif // _TRACEH_
@@ -15,11 +15,30 @@ GENERATED: On "Jun 24 2003" at "10:17:56" by Code Architect 2.01
 
 // SFR description needs to be included
 #include "reg932.h"
+#include "compiler.h"
+#include "config.h"
 #include "uart.h"
 
 // flag that indicates if the UART is busy transmitting or not
 static bit mtxbusy;
 
+// received bytes not yet collected by uart_get, the interrupt writes
+// at mrxhead and uart_get reads at mrxtail
+static unsigned char idata mrxbuf[UART_RX_SIZE];
+static unsigned char data mrxhead;
+static unsigned char data mrxtail;
+
+// baud rate generator values for UART_BAUDS
+#define UART_BRG(baud) (unsigned int)(OSC_FREQ / (baud##UL) - 16),
+static const unsigned int code mbrg[UART_BAUD_COUNT] = { UART_BAUDS(UART_BRG) };
+
+#if UART_TEST_ENABLE
+// counted by the interrupt for uart_stats
+static unsigned int idata mdropped;
+static unsigned int idata misrcalls;
+static unsigned long idata misrtime;
+#endif
+
 /***********************************************************************
 DESC:    Initializes UART for mode 1
          Baudrate: 9600
@@ -33,7 +52,6 @@ void uart_init
   void
   )
 {
-  unsigned int BRG_Val;
   // configure UART
   // clear SMOD0 to access SM0 (UART mode bit) in SCON
   PCON &= ~0x40;
@@ -51,12 +69,7 @@ void uart_init
   AUXR1 |= 0x40;
 
   // configure baud rate generator
-  BRG_Val=(unsigned int)(OSC_FREQ/9600UL);
-  BRG_Val=BRG_Val-16;
-  BRGCON = 0x00;
-  BRGR1 = BRG_Val>>8;
-  BRGR0 = (unsigned char)(BRG_Val&0xff);
-  BRGCON = 0x03;
+  uart_baud(UART_BAUD_DEFAULT);
 
   // TxD = push-pull, RxD = input
   P1M1 &= ~0x01;
@@ -64,8 +77,10 @@ void uart_init
   P1M1 |= 0x02;
   P1M2 &= ~0x02;
 
-  // initially not busy
+  // initially not busy, nothing received
   mtxbusy = 0;
+  mrxhead = 0;
+  mrxtail = 0;
 
   // set isr priority to 0
   IP0 &= 0xEF;
@@ -80,16 +95,37 @@ DESC:    UART Interrupt Service Routine
 RETURNS: Nothing
 CAUTION: uart_init must be called first
          EA must be set to 1
+         Shares register bank 1 with i2c_isr, keep both at the same
+         priority so neither can interrupt the other
 ************************************************************************/
 void uart_isr
   (
   void
   ) interrupt 4 using 1
 {
+#if UART_TEST_ENABLE
+  // timer 0 counts one a machine cycle and is reloaded only by its own
+  // interrupt, which cannot come in before this one is done, so the low
+  // byte alone times anything under 256 cycles
+  unsigned char start = TL0;
+#endif
+
   if (RI)
   {
     // clear interrupt flag
     RI = 0;
+    // keep the byte unless the buffer is full
+    if (((mrxhead + 1) % UART_RX_SIZE) != mrxtail)
+    {
+      mrxbuf[mrxhead] = SBUF;
+      mrxhead = (mrxhead + 1) % UART_RX_SIZE;
+    } // if
+#if UART_TEST_ENABLE
+    else
+    {
+      mdropped++;
+    } // else
+#endif
   } // if
 
   if (TI)
@@ -100,6 +136,10 @@ void uart_isr
     mtxbusy = 0;
   } // if
 
+#if UART_TEST_ENABLE
+  misrcalls++;
+  misrtime += (unsigned char)(TL0 - start);
+#endif
 } // uart_isr
 
 /***********************************************************************
@@ -119,15 +159,96 @@ void uart_transmit
 } // uart_transmit
 
 /***********************************************************************
-DESC:    Gets a received 8-bit value from the UART
-RETURNS: Received data
+DESC:    Checks whether uart_transmit can take a byte without waiting
+RETURNS: 1 if the UART is idle, 0 while it is still sending
+CAUTION: uart_init must be called first
+************************************************************************/
+unsigned char uart_ready
+  (
+  void
+  )
+{
+  return !mtxbusy;
+} // uart_ready
+
+/***********************************************************************
+DESC:    Checks whether a received byte is waiting for uart_get
+RETURNS: 1 if there is one, 0 if not
 CAUTION: uart_init must be called first
 ************************************************************************/
+unsigned char uart_received
+  (
+  void
+  )
+{
+  return mrxhead != mrxtail;
+} // uart_received
+
+/***********************************************************************
+DESC:    Gets the oldest received 8-bit value from the UART
+RETURNS: Received data
+CAUTION: uart_init must be called first, and uart_received must be 1
+************************************************************************/
 unsigned char uart_get
   (
   void
   )
 {
-  return SBUF;
+  unsigned char value;
+
+  value = mrxbuf[mrxtail];
+  mrxtail = (mrxtail + 1) % UART_RX_SIZE;
+  return value;
 } // uart_get
 
+/***********************************************************************
+DESC:    Switches to one of the UART_BAUDS rates
+RETURNS: Nothing
+CAUTION: wait for uart_ready first, a byte still going out is garbled
+************************************************************************/
+void uart_baud
+  (
+  unsigned char index    // into UART_BAUDS
+  )
+{
+  // the generator has to be stopped while it is loaded
+  BRGCON = 0x00;
+  BRGR1 = mbrg[index] >> 8;
+  BRGR0 = (unsigned char)(mbrg[index] & 0xff);
+  BRGCON = 0x03;
+} // uart_baud
+
+/***********************************************************************
+DESC:    Copies out and clears the counts the interrupt keeps
+RETURNS: Nothing
+CAUTION: only counted with UART_TEST_ENABLE, zeros otherwise
+************************************************************************/
+void uart_stats
+  (
+  unsigned char xdata* out    // UART_STATS bytes
+  )
+{
+  unsigned char i;
+
+  for (i = 0; i < UART_STATS; i++)
+  {
+    out[i] = 0;
+  } // for
+
+#if UART_TEST_ENABLE
+  // the counts are several bytes, keep the interrupt out while they are read
+  ES = 0;
+  out[0] = mdropped >> 8;
+  out[1] = (unsigned char)mdropped;
+  out[2] = misrcalls >> 8;
+  out[3] = (unsigned char)misrcalls;
+  out[4] = misrtime >> 24;
+  out[5] = (unsigned char)(misrtime >> 16);
+  out[6] = (unsigned char)(misrtime >> 8);
+  out[7] = (unsigned char)misrtime;
+  mdropped = 0;
+  misrcalls = 0;
+  misrtime = 0;
+  ES = 1;
+#endif
+} // uart_stats
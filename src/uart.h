@@ -16,12 +16,26 @@ GENERATED: On "Jun 24 2003" at "10:17:56" by Code Architect 2.01
 #ifndef _UARTH_
 #define _UARTH_
 
+#include "compiler.h"
+
 // values defined to calculate baud rate generation
 // Oscillator frequency
 #define OSC_FREQ (7372800UL)  // on-chip RC oscillator for P89LPC932A1
 // Number of oscillations per instruction
 #define OSC_PER_INST (2)  // 2 cycles per instruction for LPC family of 8051's
 
+// size of the receive buffer, one byte of it always stays free
+#define UART_RX_SIZE (8)
+
+// baud rates for uart_baud, by index, and the one uart_init sets
+#define UART_BAUDS(B) B(9600) B(19200) B(38400) B(57600) B(115200)
+#define UART_BAUD_COUNT (5)
+#define UART_BAUD_DEFAULT (0)
+
+// bytes written by uart_stats: receive bytes dropped, interrupts and
+// timer 0 counts spent in them, high byte first
+#define UART_STATS (8)
+
 /***********************************************************************
 DESC:    Transmits a 8-bit value via the UART in the current mode
          May result in a transmit interrupt if enabled.
@@ -34,10 +48,30 @@ extern void uart_transmit
   );
 
 /***********************************************************************
-DESC:    Gets a received 8-bit value from the UART
-RETURNS: Received data
+DESC:    Checks whether uart_transmit can take a byte without waiting
+RETURNS: 1 if the UART is idle, 0 while it is still sending
+CAUTION: uart_init must be called first
+************************************************************************/
+extern unsigned char uart_ready
+  (
+  void
+  );
+
+/***********************************************************************
+DESC:    Checks whether a received byte is waiting for uart_get
+RETURNS: 1 if there is one, 0 if not
 CAUTION: uart_init must be called first
 ************************************************************************/
+extern unsigned char uart_received
+  (
+  void
+  );
+
+/***********************************************************************
+DESC:    Gets the oldest received 8-bit value from the UART
+RETURNS: Received data
+CAUTION: uart_init must be called first, and uart_received must be 1
+************************************************************************/
 extern unsigned char uart_get
   (
   void
@@ -55,4 +89,26 @@ extern void uart_init
   void
   );
 
+/***********************************************************************
+DESC:    Switches to one of the UART_BAUDS rates
+RETURNS: Nothing
+CAUTION: wait for uart_ready first, a byte still going out is garbled
+************************************************************************/
+extern void uart_baud
+  (
+  unsigned char index    // into UART_BAUDS
+  );
+
+/***********************************************************************
+DESC:    Copies out and clears the counts the interrupt keeps: received
+         bytes dropped because the buffer was full, interrupts taken and
+         the timer 0 counts (one a machine cycle) spent in them
+RETURNS: Nothing
+CAUTION: only counted with UART_TEST_ENABLE
+************************************************************************/
+extern void uart_stats
+  (
+  unsigned char xdata* out    // UART_STATS bytes
+  );
+
 #endif // _UARTH_